@@ -31,8 +31,11 @@
 
 package de.frank_durr.ecdh_curve25519;
 
+import java.nio.ByteBuffer;
+import java.nio.ReadOnlyBufferException;
 import java.security.InvalidParameterException;
 import java.security.SecureRandom;
+import java.util.Arrays;
 
 /**
  * Diffie-Hellman key exchange based on elliptic curve 25519.
@@ -51,6 +54,14 @@ public class ECDHCurve25519 {
     
     public static final int KEY_LENGTH = 32;
 
+    // Per-thread buffer for the random number of generate_secret_key(SecureRandom, byte[], int)
+    private static final ThreadLocal<byte[]> random_buffer = new ThreadLocal<byte[]>() {
+        @Override
+        protected byte[] initialValue() {
+            return new byte[KEY_LENGTH];
+        }
+    };
+
     /**
      * Generate a random secret key. Note that the secret key is not just a random number,
      * but it is ensured that it fulfills some properties that are required to avoid
@@ -61,14 +72,29 @@ public class ECDHCurve25519 {
      * @return secret key.
      */
     public static byte[] generate_secret_key(SecureRandom random) {
-        byte[] random_number = new byte[KEY_LENGTH];
-        random.nextBytes(random_number);
+        byte[] sec_key = new byte[KEY_LENGTH];
+        random.nextBytes(sec_key);
 
-        byte[] sec_key = secret_key(random_number);
+        secret_key_into(sec_key, 0, sec_key, 0);
 
         return sec_key;
     }
 
+    /**
+     * Generate a random secret key like generate_secret_key(SecureRandom), but write it to
+     * out[out_off] to out[out_off + KEY_LENGTH - 1] instead of allocating a new array.
+     *
+     * @param random random number generator (RNG).
+     * @param out array receiving the secret key.
+     * @param out_off offset of the secret key in out.
+     */
+    public static void generate_secret_key(SecureRandom random, byte[] out, int out_off) {
+        byte[] random_number = random_buffer.get();
+        random.nextBytes(random_number);
+        secret_key_into(random_number, 0, out, out_off);
+        Arrays.fill(random_number, (byte) 0);
+    }
+
     /**
      * Calculate a public key from a secret key.
      *
@@ -80,7 +106,8 @@ public class ECDHCurve25519 {
             throw new InvalidParameterException("Key length must be " + KEY_LENGTH);
         }
 
-        byte[] pub_key = public_key(secret_key);
+        byte[] pub_key = new byte[KEY_LENGTH];
+        public_key_into(secret_key, 0, pub_key, 0);
 
         return pub_key;
     }
@@ -98,14 +125,170 @@ public class ECDHCurve25519 {
             throw new InvalidParameterException("Key length must be " + KEY_LENGTH);
         }
 
-        byte[] shared_secret = shared_secret(my_secret_key, other_public_key);
+        byte[] shared_secret = new byte[KEY_LENGTH];
+        shared_secret_into(my_secret_key, 0, other_public_key, 0, shared_secret, 0);
 
         return shared_secret;
     }
 
-    private static native byte[] secret_key(byte[] random_number);
+    /**
+     * Calculate a public key from a secret key like generate_public_key(byte[]), but read
+     * the secret key from and write the public key to the given offsets of caller-provided
+     * arrays instead of allocating a new array.
+     *
+     * @param secret_key array containing the secret key.
+     * @param secret_key_off offset of the secret key in secret_key.
+     * @param out array receiving the public key.
+     * @param out_off offset of the public key in out.
+     */
+    public static void generate_public_key(byte[] secret_key, int secret_key_off,
+                                           byte[] out, int out_off) {
+        public_key_into(secret_key, secret_key_off, out, out_off);
+    }
+
+    /**
+     * Calculate the shared secret like generate_shared_secret(byte[], byte[]), but read the
+     * keys from and write the shared secret to the given offsets of caller-provided arrays
+     * instead of allocating a new array. The shared secret may overwrite one of the keys.
+     *
+     * @param my_secret_key array containing the secret key of the entity calculating the
+     *                      shared secret.
+     * @param my_secret_key_off offset of the secret key in my_secret_key.
+     * @param other_public_key array containing the public key of the other entity of the
+     *                         key exchange.
+     * @param other_public_key_off offset of the public key in other_public_key.
+     * @param out array receiving the shared secret.
+     * @param out_off offset of the shared secret in out.
+     */
+    public static void generate_shared_secret(byte[] my_secret_key, int my_secret_key_off,
+                                              byte[] other_public_key, int other_public_key_off,
+                                              byte[] out, int out_off) {
+        shared_secret_into(my_secret_key, my_secret_key_off,
+                other_public_key, other_public_key_off, out, out_off);
+    }
+
+    /**
+     * Calculate count public keys in one call. The secret keys are read from secret_keys,
+     * which holds count keys of KEY_LENGTH bytes one after the other; the public keys are
+     * written to out in the same layout.
+     *
+     * @param secret_keys array of count secret keys.
+     * @param out array receiving the count public keys.
+     * @param count number of keys.
+     */
+    public static void generate_public_keys(byte[] secret_keys, byte[] out, int count) {
+        public_keys(secret_keys, out, count);
+    }
+
+    /**
+     * Calculate the shared secrets of one secret key with count public keys of other
+     * entities in one call. This is considerably faster than calling
+     * generate_shared_secret count times. The public keys are read from other_public_keys,
+     * which holds count keys of KEY_LENGTH bytes one after the other; the shared secrets
+     * are written to out in the same layout.
+     *
+     * @param my_secret_key secret key of the entity calculating the shared secrets.
+     * @param other_public_keys array of count public keys of the other entities.
+     * @param out array receiving the count shared secrets.
+     * @param count number of public keys.
+     */
+    public static void generate_shared_secrets(byte[] my_secret_key, byte[] other_public_keys,
+                                               byte[] out, int count) {
+        shared_secrets(my_secret_key, other_public_keys, out, count);
+    }
+
+    /**
+     * Calculate a public key from a secret key stored in a direct byte buffer. The key is
+     * read from the KEY_LENGTH bytes at the current position of secret_key. The public key
+     * is written to the KEY_LENGTH bytes at the current position of public_key. The
+     * positions of the buffers are not changed. The native code accesses the buffers
+     * directly, so nothing is copied or allocated on the Java heap.
+     *
+     * @param secret_key direct buffer containing the secret key.
+     * @param public_key direct buffer receiving the public key (x value of a point on the
+     *                   curve in Little Endian byte order).
+     */
+    public static void generate_public_key(ByteBuffer secret_key, ByteBuffer public_key) {
+        check_direct_buffer(secret_key);
+        check_direct_buffer(public_key);
+        if (public_key.isReadOnly()) {
+            throw new ReadOnlyBufferException();
+        }
+
+        public_key_direct(secret_key, secret_key.position(), public_key, public_key.position());
+    }
+
+    /**
+     * Calculate the shared secret from an entity's secret key and the public key of the
+     * other entity participating in the key exchange, both stored in direct byte buffers.
+     * Each key is read from the KEY_LENGTH bytes at the current position of its buffer.
+     * The shared secret is written to the KEY_LENGTH bytes at the current position of
+     * shared_secret and may overwrite one of the keys. The positions of the buffers are
+     * not changed.
+     *
+     * @param my_secret_key direct buffer containing the secret key of the entity
+     *                      calculating the shared secret.
+     * @param other_public_key direct buffer containing the public key of the other entity
+     *                         of the key exchange.
+     * @param shared_secret direct buffer receiving the shared secret.
+     */
+    public static void generate_shared_secret(ByteBuffer my_secret_key,
+                                              ByteBuffer other_public_key,
+                                              ByteBuffer shared_secret) {
+        check_direct_buffer(my_secret_key);
+        check_direct_buffer(other_public_key);
+        check_direct_buffer(shared_secret);
+        if (shared_secret.isReadOnly()) {
+            throw new ReadOnlyBufferException();
+        }
+
+        shared_secret_direct(my_secret_key, my_secret_key.position(),
+                other_public_key, other_public_key.position(),
+                shared_secret, shared_secret.position());
+    }
+
+    private static void check_direct_buffer(ByteBuffer buffer) {
+        if (!buffer.isDirect()) {
+            throw new InvalidParameterException("Buffer must be a direct buffer");
+        }
+        if (buffer.remaining() < KEY_LENGTH) {
+            throw new InvalidParameterException("Buffer must have " + KEY_LENGTH +
+                    " bytes remaining");
+        }
+    }
+
+    // The native methods are registered by JNI_OnLoad of the native library. Those taking
+    // arrays and offsets check that the arrays are long enough and throw
+    // InvalidParameterException otherwise.
+
+    private static native void secret_key_into(byte[] random_number, int random_number_off,
+                                               byte[] out, int out_off);
+
+    private static native void public_key_into(byte[] secret_key, int secret_key_off,
+                                               byte[] out, int out_off);
+
+    private static native void shared_secret_into(byte[] my_secret_key, int my_secret_key_off,
+                                                  byte[] other_public_key,
+                                                  int other_public_key_off,
+                                                  byte[] out, int out_off);
+
+    private static native void public_keys(byte[] secret_keys, byte[] out, int count);
+
+    private static native void shared_secrets(byte[] my_secret_key, byte[] other_public_keys,
+                                              byte[] out, int count);
+
+    // Like shared_secrets, but spread over a pool of native threads; blocks until all
+    // shared secrets are done. Used by ECDHCurve25519Async.
+    static native void shared_secrets_parallel(byte[] my_secret_key, byte[] other_public_keys,
+                                               byte[] out, int count);
 
-    private static native byte[] public_key(byte[] secret_key);
+    private static native void public_key_direct(ByteBuffer secret_key, int secret_key_off,
+                                                 ByteBuffer public_key, int public_key_off);
 
-    private static native byte[] shared_secret(byte[] my_secret_key, byte[] other_public_key);
+    private static native void shared_secret_direct(ByteBuffer my_secret_key,
+                                                    int my_secret_key_off,
+                                                    ByteBuffer other_public_key,
+                                                    int other_public_key_off,
+                                                    ByteBuffer shared_secret,
+                                                    int shared_secret_off);
 }
@@ -0,0 +1,258 @@
+/**
+ * This file is part of ECDH-Curve25519-Mobile.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+
+package de.frank_durr.ecdh_curve25519;
+
+import java.security.InvalidParameterException;
+import java.util.Arrays;
+import java.util.concurrent.ArrayBlockingQueue;
+import java.util.concurrent.CompletableFuture;
+import java.util.concurrent.Executor;
+import java.util.concurrent.RejectedExecutionException;
+import java.util.concurrent.ThreadFactory;
+import java.util.concurrent.ThreadPoolExecutor;
+import java.util.concurrent.TimeUnit;
+import java.util.concurrent.atomic.AtomicInteger;
+import java.util.function.Supplier;
+
+/**
+ * Asynchronous variants of the key generation and key agreement functions of
+ * ECDHCurve25519. The scalar multiplications run on a bounded pool of background threads,
+ * so latency-sensitive threads (an Android UI thread, the event loop of a server) are not
+ * blocked for the duration of the ladder.
+ *
+ * The pool has one thread per available processor and queues at most QUEUE_CAPACITY
+ * operations; further operations fail with a RejectedExecutionException instead of
+ * piling up. The threads are daemon threads and are created on first use.
+ *
+ * Single operations run on a Java pool because one scalar multiplication is too short to
+ * be worth splitting. Batches of shared secrets (generate_shared_secrets_async) are handed
+ * to the pool of native worker threads of the library: the pool thread taking the batch
+ * works on it together with the native threads, so one large batch uses all processors.
+ *
+ * The key arrays are copied when an operation is submitted, so the caller may reuse or wipe
+ * them right away. The copies are zeroed when the operation is done.
+ *
+ * By default, the returned futures are completed on a pool thread, so dependent actions
+ * without an explicit executor run there. The variants taking a callback executor complete
+ * the future on that executor instead (e.g., the executor of the Android main looper).
+ *
+ * This class uses java.util.concurrent.CompletableFuture and therefore needs Java 8 or
+ * Android API level 24; ECDHCurve25519 itself does not depend on it.
+ */
+public class ECDHCurve25519Async {
+
+    /**
+     * Maximum number of operations waiting for a pool thread.
+     */
+    public static final int QUEUE_CAPACITY = 1024;
+
+    private static final class PoolHolder {
+        static final ThreadPoolExecutor pool = create_pool();
+    }
+
+    private static ThreadPoolExecutor create_pool() {
+        final int threads = Math.max(1, Runtime.getRuntime().availableProcessors());
+        final AtomicInteger count = new AtomicInteger();
+        ThreadFactory factory = runnable -> {
+            Thread thread = new Thread(runnable, "ecdh-curve25519-" + count.incrementAndGet());
+            thread.setDaemon(true);
+            return thread;
+        };
+        ThreadPoolExecutor pool = new ThreadPoolExecutor(threads, threads, 30, TimeUnit.SECONDS,
+                new ArrayBlockingQueue<Runnable>(QUEUE_CAPACITY), factory,
+                new ThreadPoolExecutor.AbortPolicy());
+        pool.allowCoreThreadTimeOut(true);
+        return pool;
+    }
+
+    /**
+     * Calculate a public key from a secret key in the background.
+     *
+     * @param secret_key secret key.
+     * @return future completed with the public key.
+     */
+    public static CompletableFuture<byte[]> generate_public_key_async(byte[] secret_key) {
+        return generate_public_key_async(secret_key, null);
+    }
+
+    /**
+     * Calculate a public key from a secret key in the background and complete the future on
+     * the given executor.
+     *
+     * @param secret_key secret key.
+     * @param callback_executor executor completing the future, or null to complete it on
+     *                          the pool thread.
+     * @return future completed with the public key.
+     */
+    public static CompletableFuture<byte[]> generate_public_key_async(
+            final byte[] secret_key, Executor callback_executor) {
+        final byte[] secret_key_copy = copy(secret_key);
+        return submit(() -> ECDHCurve25519.generate_public_key(secret_key_copy),
+                callback_executor, secret_key_copy);
+    }
+
+    /**
+     * Calculate the shared secret from an entity's secret key and the public key of the
+     * other entity in the background.
+     *
+     * @param my_secret_key secret key of the entity calculating the shared secret.
+     * @param other_public_key the public key of the other entity of the key exchange.
+     * @return future completed with the shared secret.
+     */
+    public static CompletableFuture<byte[]> generate_shared_secret_async(
+            byte[] my_secret_key, byte[] other_public_key) {
+        return generate_shared_secret_async(my_secret_key, other_public_key, null);
+    }
+
+    /**
+     * Calculate the shared secret from an entity's secret key and the public key of the
+     * other entity in the background and complete the future on the given executor.
+     *
+     * @param my_secret_key secret key of the entity calculating the shared secret.
+     * @param other_public_key the public key of the other entity of the key exchange.
+     * @param callback_executor executor completing the future, or null to complete it on
+     *                          the pool thread.
+     * @return future completed with the shared secret.
+     */
+    public static CompletableFuture<byte[]> generate_shared_secret_async(
+            final byte[] my_secret_key, final byte[] other_public_key,
+            Executor callback_executor) {
+        final byte[] my_secret_key_copy = copy(my_secret_key);
+        final byte[] other_public_key_copy = copy(other_public_key);
+        return submit(() -> ECDHCurve25519.generate_shared_secret(my_secret_key_copy,
+                other_public_key_copy), callback_executor, my_secret_key_copy,
+                other_public_key_copy);
+    }
+
+    /**
+     * Calculate the shared secrets of one secret key with count public keys of other
+     * entities in the background, spread over the native worker threads of the library.
+     * The public keys are read from other_public_keys, which holds count keys of KEY_LENGTH
+     * bytes one after the other; the shared secrets are returned in the same layout.
+     *
+     * @param my_secret_key secret key of the entity calculating the shared secrets.
+     * @param other_public_keys array of count public keys of the other entities.
+     * @param count number of public keys.
+     * @return future completed with the count shared secrets.
+     */
+    public static CompletableFuture<byte[]> generate_shared_secrets_async(
+            byte[] my_secret_key, byte[] other_public_keys, int count) {
+        return generate_shared_secrets_async(my_secret_key, other_public_keys, count, null);
+    }
+
+    /**
+     * Calculate the shared secrets of one secret key with count public keys of other
+     * entities in the background and complete the future on the given executor.
+     *
+     * @param my_secret_key secret key of the entity calculating the shared secrets.
+     * @param other_public_keys array of count public keys of the other entities.
+     * @param count number of public keys.
+     * @param callback_executor executor completing the future, or null to complete it on
+     *                          the pool thread.
+     * @return future completed with the count shared secrets.
+     */
+    public static CompletableFuture<byte[]> generate_shared_secrets_async(
+            byte[] my_secret_key, byte[] other_public_keys, final int count,
+            Executor callback_executor) {
+        final byte[] my_secret_key_copy = copy(my_secret_key);
+        final byte[] other_public_keys_copy = copy(other_public_keys);
+        return submit(() -> {
+            if (count < 0 || count > Integer.MAX_VALUE/ECDHCurve25519.KEY_LENGTH) {
+                throw new InvalidParameterException("Invalid number of keys: " + count);
+            }
+            byte[] out = new byte[count*ECDHCurve25519.KEY_LENGTH];
+            ECDHCurve25519.shared_secrets_parallel(my_secret_key_copy, other_public_keys_copy,
+                    out, count);
+            return out;
+        }, callback_executor, my_secret_key_copy, other_public_keys_copy);
+    }
+
+    // Copy of an input array, taken before the operation is queued. Null is passed on, so
+    // that the operation fails as the synchronous call would.
+    private static byte[] copy(byte[] array) {
+        return array != null ? array.clone() : null;
+    }
+
+    private static void wipe(byte[][] arrays) {
+        for (byte[] array : arrays) {
+            if (array != null) {
+                Arrays.fill(array, (byte) 0);
+            }
+        }
+    }
+
+    // Run operation on the pool. The result (or exception) is passed to the returned
+    // future, on callback_executor if it is not null. The copied inputs of the operation
+    // are zeroed when it is done.
+    private static CompletableFuture<byte[]> submit(final Supplier<byte[]> operation,
+                                                    final Executor callback_executor,
+                                                    final byte[]... inputs) {
+        final CompletableFuture<byte[]> future = new CompletableFuture<>();
+        try {
+            PoolHolder.pool.execute(() -> {
+                byte[] result = null;
+                Throwable error = null;
+                try {
+                    result = operation.get();
+                } catch (Throwable t) {
+                    error = t;
+                } finally {
+                    wipe(inputs);
+                }
+                complete(future, result, error, callback_executor);
+            });
+        } catch (RejectedExecutionException e) {
+            wipe(inputs);
+            future.completeExceptionally(e);
+        }
+        return future;
+    }
+
+    private static void complete(final CompletableFuture<byte[]> future, final byte[] result,
+                                 final Throwable error, Executor callback_executor) {
+        Runnable completion = () -> {
+            if (error != null) {
+                future.completeExceptionally(error);
+            } else {
+                future.complete(result);
+            }
+        };
+        if (callback_executor == null) {
+            completion.run();
+            return;
+        }
+        try {
+            callback_executor.execute(completion);
+        } catch (Throwable t) {
+            // Whatever the executor throws, the future must not stay incomplete.
+            future.completeExceptionally(t);
+        }
+    }
+}
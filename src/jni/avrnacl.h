@@ -24,6 +24,10 @@ typedef int32_t crypto_int32;
 typedef uint32_t crypto_uint32;
 typedef int64_t crypto_int64;
 typedef uint64_t crypto_uint64;
+#ifdef __SIZEOF_INT128__
+__extension__ typedef __int128 crypto_int128;
+__extension__ typedef unsigned __int128 crypto_uint128;
+#endif
 
 // Modifications compared to avrnacl: removed anything not necessary for 
 // implementing ECDH. Just kept Curve 25519 functionality.
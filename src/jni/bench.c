@@ -0,0 +1,637 @@
+/**
+ * This file is part of ECDH-Curve25519-Mobile.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+
+/*
+ * Benchmark of the native code: latency of the field arithmetic, of one
+ * ladder step and of the ECDH operations. Every function is run for a
+ * number of warm-up samples, then for a number of measured samples; one
+ * sample times a batch of calls that takes at least SAMPLE_NS
+ * nanoseconds, so that the overhead of reading the clock does not count.
+ * Reported are the minimum, median, mean, 90th and 99th percentile of the
+ * time per call in nanoseconds and, if a cycle counter is available, in
+ * cycles.
+ *
+ * ecdh_curve25519_shared_secret is measured for every implementation of
+ * crypto_scalarmult_curve25519 the CPU supports. The other functions do
+ * not depend on this choice and are measured once; they are reported with
+ * the name of the field backend (e.g., "radix51").
+ *
+ * With -b, the medians are compared with those of a baseline file written
+ * by an earlier run with -j (e.g., bench_baseline_x86_64.json). The
+ * program exits with status 1 if a function measured in both runs got
+ * slower by more than the threshold given with -t (default 10 percent).
+ * The JSON output records the CPU model, the compiler and the build flags
+ * (BENCH_BUILD_FLAGS, set by the build), and -b warns if the baseline was
+ * recorded on another CPU.
+ *
+ * Usage: bench [-r runs] [-w warmup] [-c cpu] [-i implementation]
+ *              [-f function] [-j] [-b baseline] [-t percent]
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "ecdh_curve25519.h"
+#include "bigint.h"
+#include "fe25519.h"
+#include "curve25519_dispatch.h"
+
+#define SAMPLE_NS 10000
+#define MAX_OPS_PER_SAMPLE (1u << 20)
+#define KEYS 8
+#define MAX_RESULTS 64
+#define MAX_BASELINE (1 << 20)
+
+#ifndef BENCH_BUILD_FLAGS
+#define BENCH_BUILD_FLAGS "unknown"
+#endif
+
+#if defined(__clang__)
+#define COMPILER_NAME __VERSION__
+#elif defined(__GNUC__)
+#define COMPILER_NAME "gcc " __VERSION__
+#else
+#define COMPILER_NAME "unknown"
+#endif
+
+#if defined(FE25519_RADIX51)
+#define FIELD_NAME "radix51"
+#elif defined(FE25519_RADIX25)
+#define FIELD_NAME "radix25"
+#else
+#define FIELD_NAME "radix8"
+#endif
+
+typedef struct {
+     double min;
+     double median;
+     double mean;
+     double p90;
+     double p99;
+} stats;
+
+typedef struct {
+     const char *function;
+     const char *implementation;
+     double median;
+} result_entry;
+
+typedef struct {
+     const char *name;
+     void (*run)(unsigned int n);
+     int per_implementation;
+} benchmark;
+
+static unsigned int runs = 1000;
+static unsigned int warmup = 100;
+static int json;
+static result_entry results[MAX_RESULTS];
+static int nresults;
+
+/* Operands; the results are fed back into the next call so that the
+ * compiler cannot drop or overlap the calls. */
+static unsigned char big_a[32], big_b[32], big_r[64];
+static fe25519 fe_a, fe_b;
+static fe25519 work[5];
+static uint8_t secret_key[KEYS][ECDH_CURVE25519_KEY_LENGTH];
+static uint8_t public_key[KEYS][ECDH_CURVE25519_KEY_LENGTH];
+static uint8_t result[ECDH_CURVE25519_KEY_LENGTH];
+
+/* Deterministic inputs, so that runs can be compared */
+static uint64_t prng_state = 0x9e3779b97f4a7c15ULL;
+
+static void create_random_number(uint8_t *random_number, size_t len)
+{
+     for (size_t i = 0; i < len; i++) {
+          prng_state ^= prng_state << 13;
+          prng_state ^= prng_state >> 7;
+          prng_state ^= prng_state << 17;
+          random_number[i] = (uint8_t) (prng_state >> 24);
+     }
+}
+
+/* Cycle counter: the CPU cycle counter of the kernel if it can be
+ * opened, the time-stamp counter on x86 otherwise. */
+static const char *cycle_counter = "none";
+static char cpu_model[128] = "unknown";
+
+/* CPU model as reported by the kernel, for the record */
+static void cpu_model_init(void)
+{
+     FILE *f = fopen("/proc/cpuinfo", "r");
+     char line[256];
+     if (f == NULL)
+          return;
+     while (fgets(line, sizeof(line), f) != NULL) {
+          if (strncmp(line, "model name", 10) != 0 &&
+              strncmp(line, "Hardware", 8) != 0)
+               continue;
+          const char *p = strchr(line, ':');
+          if (p == NULL)
+               continue;
+          p += strspn(p + 1, " \t") + 1;
+          size_t n = strcspn(p, "\n");
+          if (n >= sizeof(cpu_model))
+               n = sizeof(cpu_model) - 1;
+          memcpy(cpu_model, p, n);
+          cpu_model[n] = '\0';
+          break;
+     }
+     fclose(f);
+}
+
+/* Print s as a JSON string */
+static void print_json_string(const char *s)
+{
+     putchar('"');
+     for (; *s != '\0'; s++) {
+          if (*s == '"' || *s == '\\')
+               putchar('\\');
+          if ((unsigned char) *s >= 0x20)
+               putchar(*s);
+     }
+     putchar('"');
+}
+static int perf_fd = -1;
+
+static void cycles_init(void)
+{
+#if defined(__linux__)
+     struct perf_event_attr attr;
+     memset(&attr, 0, sizeof(attr));
+     attr.type = PERF_TYPE_HARDWARE;
+     attr.size = sizeof(attr);
+     attr.config = PERF_COUNT_HW_CPU_CYCLES;
+     attr.exclude_kernel = 1;
+     attr.exclude_hv = 1;
+     perf_fd = (int) syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+     if (perf_fd >= 0) {
+          cycle_counter = "perf";
+          return;
+     }
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+     cycle_counter = "tsc";
+#endif
+}
+
+static uint64_t cycles(void)
+{
+#if defined(__linux__)
+     if (perf_fd >= 0) {
+          uint64_t c;
+          if (read(perf_fd, &c, sizeof(c)) == sizeof(c))
+               return c;
+          return 0;
+     }
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+     return __rdtsc();
+#else
+     return 0;
+#endif
+}
+
+static uint64_t nanoseconds(void)
+{
+     struct timespec ts;
+     clock_gettime(CLOCK_MONOTONIC, &ts);
+     return (uint64_t) ts.tv_sec*1000000000 + ts.tv_nsec;
+}
+
+static void run_bigint_mul32(unsigned int n)
+{
+     for (unsigned int i = 0; i < n; i++) {
+          bigint_mul32(big_r, big_a, big_b);
+          memcpy(big_a, big_r + 32, 32);
+     }
+}
+
+static void run_fe25519_mul(unsigned int n)
+{
+     for (unsigned int i = 0; i < n; i++)
+          fe25519_mul(&fe_a, &fe_a, &fe_b);
+}
+
+static void run_fe25519_square(unsigned int n)
+{
+     for (unsigned int i = 0; i < n; i++)
+          fe25519_square(&fe_a, &fe_a);
+}
+
+static void run_fe25519_invert(unsigned int n)
+{
+     for (unsigned int i = 0; i < n; i++)
+          fe25519_invert(&fe_a, &fe_a);
+}
+
+static void run_ladderstep(unsigned int n)
+{
+     for (unsigned int i = 0; i < n; i++)
+          crypto_scalarmult_curve25519_ladderstep(work);
+}
+
+static void run_scalarmult(unsigned int n)
+{
+     for (unsigned int i = 0; i < n; i++) {
+          crypto_scalarmult_curve25519(result, secret_key[i % KEYS],
+                                       public_key[(i + 1) % KEYS]);
+          secret_key[i % KEYS][1] ^= result[1];
+     }
+}
+
+static void run_public_key(unsigned int n)
+{
+     for (unsigned int i = 0; i < n; i++) {
+          ecdh_curve25519_public_key(result, secret_key[i % KEYS]);
+          secret_key[i % KEYS][1] ^= result[1];
+     }
+}
+
+static void run_shared_secret(unsigned int n)
+{
+     for (unsigned int i = 0; i < n; i++) {
+          ecdh_curve25519_shared_secret(result, secret_key[i % KEYS],
+                                        public_key[(i + 1) % KEYS]);
+          secret_key[i % KEYS][1] ^= result[1];
+     }
+}
+
+static const benchmark benchmarks[] = {
+     {"bigint_mul32", run_bigint_mul32, 0},
+     {"fe25519_mul", run_fe25519_mul, 0},
+     {"fe25519_square", run_fe25519_square, 0},
+     {"fe25519_invert", run_fe25519_invert, 0},
+     {"ladderstep", run_ladderstep, 0},
+     {"crypto_scalarmult_curve25519", run_scalarmult, 1},
+     {"ecdh_curve25519_public_key", run_public_key, 0},
+     {"ecdh_curve25519_shared_secret", run_shared_secret, 1},
+};
+
+static void setup(void)
+{
+     uint8_t random_number[ECDH_CURVE25519_KEY_LENGTH];
+
+     create_random_number(big_a, sizeof(big_a));
+     create_random_number(big_b, sizeof(big_b));
+     create_random_number(random_number, sizeof(random_number));
+     fe25519_unpack(&fe_a, random_number);
+     create_random_number(random_number, sizeof(random_number));
+     fe25519_unpack(&fe_b, random_number);
+     for (int i = 0; i < 5; i++) {
+          create_random_number(random_number, sizeof(random_number));
+          fe25519_unpack(&work[i], random_number);
+     }
+     for (int i = 0; i < KEYS; i++) {
+          create_random_number(random_number, sizeof(random_number));
+          ecdh_curve25519_secret_key(secret_key[i], random_number);
+          ecdh_curve25519_public_key(public_key[i], secret_key[i]);
+     }
+}
+
+static int compare_double(const void *a, const void *b)
+{
+     double x = *(const double *) a;
+     double y = *(const double *) b;
+     return (x > y) - (x < y);
+}
+
+/* Nearest-rank percentiles of the n samples in v (sorts v) */
+static void compute_stats(stats *s, double *v, unsigned int n)
+{
+     double sum = 0;
+     qsort(v, n, sizeof(double), compare_double);
+     for (unsigned int i = 0; i < n; i++)
+          sum += v[i];
+     s->min = v[0];
+     s->median = v[(n - 1)/2];
+     s->mean = sum/n;
+     s->p90 = v[(n*90 + 99)/100 - 1];
+     s->p99 = v[(n*99 + 99)/100 - 1];
+}
+
+/* Number of calls per sample such that a sample takes at least SAMPLE_NS */
+static unsigned int calibrate(const benchmark *b)
+{
+     unsigned int n = 1;
+     while (n < MAX_OPS_PER_SAMPLE) {
+          uint64_t t = nanoseconds();
+          b->run(n);
+          if (nanoseconds() - t >= SAMPLE_NS)
+               break;
+          n *= 2;
+     }
+     return n;
+}
+
+static int first_result = 1;
+
+static void report(const char *function, const char *implementation,
+                   unsigned int ops, const stats *ns, const stats *cyc)
+{
+     if (nresults < MAX_RESULTS) {
+          results[nresults].function = function;
+          results[nresults].implementation = implementation;
+          results[nresults].median = ns->median;
+          nresults++;
+     }
+     if (!json) {
+          printf("%-30s %-8s %12.1f %12.1f %12.1f %12.1f",
+                 function, implementation, ns->median, ns->p90, ns->p99,
+                 ns->min);
+          if (cyc)
+               printf(" %12.0f %12.0f", cyc->median, cyc->p90);
+          printf("\n");
+          return;
+     }
+     printf("%s\n    {\"function\": \"%s\", \"implementation\": \"%s\", "
+            "\"runs\": %u, \"ops_per_run\": %u,\n",
+            first_result ? "" : ",", function, implementation, runs, ops);
+     printf("     \"ns\": {\"min\": %.2f, \"median\": %.2f, \"mean\": %.2f, "
+            "\"p90\": %.2f, \"p99\": %.2f}",
+            ns->min, ns->median, ns->mean, ns->p90, ns->p99);
+     if (cyc)
+          printf(",\n     \"cycles\": {\"min\": %.1f, \"median\": %.1f, "
+                 "\"mean\": %.1f, \"p90\": %.1f, \"p99\": %.1f}}",
+                 cyc->min, cyc->median, cyc->mean, cyc->p90, cyc->p99);
+     else
+          printf(",\n     \"cycles\": null}");
+     first_result = 0;
+}
+
+static void measure(const benchmark *b, const char *implementation,
+                    double *ns, double *cyc)
+{
+     stats ns_stats, cyc_stats;
+     unsigned int ops = calibrate(b);
+     int have_cycles = perf_fd >= 0 || strcmp(cycle_counter, "tsc") == 0;
+
+     for (unsigned int i = 0; i < warmup; i++)
+          b->run(ops);
+     for (unsigned int i = 0; i < runs; i++) {
+          uint64_t c0 = cycles();
+          uint64_t t0 = nanoseconds();
+          b->run(ops);
+          uint64_t t1 = nanoseconds();
+          uint64_t c1 = cycles();
+          ns[i] = (double) (t1 - t0)/ops;
+          cyc[i] = (double) (c1 - c0)/ops;
+     }
+     compute_stats(&ns_stats, ns, runs);
+     compute_stats(&cyc_stats, cyc, runs);
+     report(b->name, implementation, ops, &ns_stats,
+            have_cycles ? &cyc_stats : NULL);
+}
+
+/* Value of the string after the key "name" that follows *pos in the JSON
+ * text, copied to buf; advances *pos past it. Returns 0 if there is none
+ * before end. */
+static int json_string(const char **pos, const char *end, const char *name,
+                       char *buf, size_t len)
+{
+     char key[64];
+     snprintf(key, sizeof(key), "\"%s\"", name);
+     const char *p = strstr(*pos, key);
+     if (p == NULL || (end != NULL && p >= end))
+          return 0;
+     p = strchr(p + strlen(key), '"');
+     if (p == NULL)
+          return 0;
+     const char *q = strchr(++p, '"');
+     if (q == NULL || (size_t) (q - p) >= len)
+          return 0;
+     memcpy(buf, p, q - p);
+     buf[q - p] = '\0';
+     *pos = q + 1;
+     return 1;
+}
+
+/* Compare the results of this run with the baseline file written by
+ * bench -j. Returns the number of regressions. Only the median time per
+ * call of entries with the same function and implementation is compared. */
+static int compare_baseline(const char *path, double threshold)
+{
+     FILE *f = fopen(path, "r");
+     if (f == NULL) {
+          fprintf(stderr, "cannot open %s: %s\n", path, strerror(errno));
+          exit(1);
+     }
+     char *text = malloc(MAX_BASELINE + 1);
+     if (text == NULL) {
+          fprintf(stderr, "out of memory\n");
+          exit(1);
+     }
+     size_t len = fread(text, 1, MAX_BASELINE, f);
+     text[len] = '\0';
+     fclose(f);
+
+     FILE *out = json ? stderr : stdout;
+     int regressions = 0;
+     int compared = 0;
+     const char *pos = text;
+     char function[64], implementation[32], cpu[128];
+     if (json_string(&pos, NULL, "cpu", cpu, sizeof(cpu)) &&
+         strcmp(cpu, cpu_model) != 0)
+          fprintf(out, "\nwarning: the baseline was recorded on %s, this is "
+                  "%s\n", cpu, cpu_model);
+     pos = text;
+     fprintf(out, "\ncomparison with %s (threshold %.1f%%)\n"
+             "%-30s %-8s %12s %12s %9s\n", path, threshold, "function",
+             "impl", "base ns", "now ns", "change");
+     while (json_string(&pos, NULL, "function", function, sizeof(function))) {
+          const char *end = strstr(pos, "\"function\"");
+          if (!json_string(&pos, end, "implementation", implementation,
+                           sizeof(implementation)))
+               continue;
+          const char *ns = strstr(pos, "\"ns\"");
+          const char *median = ns ? strstr(ns, "\"median\":") : NULL;
+          if (median == NULL || (end != NULL && median >= end))
+               continue;
+          double base = atof(median + strlen("\"median\":"));
+          for (int i = 0; i < nresults; i++) {
+               if (strcmp(results[i].function, function) != 0 ||
+                   strcmp(results[i].implementation, implementation) != 0)
+                    continue;
+               double change = (results[i].median/base - 1)*100;
+               int slower = change > threshold;
+               fprintf(out, "%-30s %-8s %12.1f %12.1f %+8.1f%%%s\n",
+                       function, implementation, base, results[i].median,
+                       change, slower ? "  REGRESSION" : "");
+               regressions += slower;
+               compared++;
+          }
+     }
+     free(text);
+     if (compared == 0)
+          fprintf(out, "no function of this run is in the baseline\n");
+     else
+          fprintf(out, "%d of %d functions regressed\n", regressions, compared);
+     return regressions;
+}
+
+static void usage(const char *prog)
+{
+     fprintf(stderr,
+             "usage: %s [-r runs] [-w warmup] [-c cpu] [-i implementation] "
+             "[-f function] [-j]\n"
+             "       [-b baseline] [-t percent]\n"
+             "  -r runs            measured samples per function (default %u)\n"
+             "  -w warmup          discarded samples per function (default %u)\n"
+             "  -c cpu             pin the process to this CPU\n"
+             "  -i implementation  only this implementation of "
+             "crypto_scalarmult_curve25519\n"
+             "  -f function        only functions whose name contains this\n"
+             "  -j                 JSON output\n"
+             "  -b baseline        compare with a file written with -j\n"
+             "  -t percent         regression threshold for -b (default "
+             "10)\n",
+             prog, runs, warmup);
+}
+
+int main(int argc, char *argv[])
+{
+     const char *only_impl = NULL;
+     const char *only_function = NULL;
+     const char *baseline = NULL;
+     double threshold = 10;
+     const char *implementations[16];
+     int nimpl = 0;
+     int cpu = -1;
+     int opt;
+
+     while ((opt = getopt(argc, argv, "r:w:c:i:f:jb:t:h")) != -1) {
+          switch (opt) {
+          case 'r': runs = (unsigned int) atoi(optarg); break;
+          case 'w': warmup = (unsigned int) atoi(optarg); break;
+          case 'c': cpu = atoi(optarg); break;
+          case 'i': only_impl = optarg; break;
+          case 'f': only_function = optarg; break;
+          case 'j': json = 1; break;
+          case 'b': baseline = optarg; break;
+          case 't': threshold = atof(optarg); break;
+          default: usage(argv[0]); return 2;
+          }
+     }
+     if (runs == 0) {
+          usage(argv[0]);
+          return 2;
+     }
+
+     if (cpu >= 0) {
+          cpu_set_t set;
+          CPU_ZERO(&set);
+          CPU_SET(cpu, &set);
+          if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+               fprintf(stderr, "cannot pin to CPU %d: %s\n", cpu,
+                       strerror(errno));
+               return 1;
+          }
+     }
+
+     for (int i = 0; nimpl < 16; i++) {
+          const char *name = crypto_scalarmult_curve25519_implementation_name(i);
+          if (name == NULL)
+               break;
+          if (only_impl == NULL || strcmp(only_impl, name) == 0)
+               implementations[nimpl++] = name;
+     }
+     if (only_impl != NULL && nimpl == 0) {
+          fprintf(stderr, "implementation %s is not supported\n", only_impl);
+          return 1;
+     }
+
+     double *ns = malloc(runs*sizeof(double));
+     double *cyc = malloc(runs*sizeof(double));
+     if (ns == NULL || cyc == NULL) {
+          fprintf(stderr, "out of memory\n");
+          return 1;
+     }
+
+     cycles_init();
+     cpu_model_init();
+     setup();
+
+     if (json) {
+          printf("{\"cpu\": ");
+          print_json_string(cpu_model);
+          printf(", \"compiler\": ");
+          print_json_string(COMPILER_NAME);
+          printf(", \"flags\": ");
+          print_json_string(BENCH_BUILD_FLAGS);
+          printf(",\n \"field\": \"%s\", \"cycle_counter\": \"%s\", "
+                 "\"results\": [", FIELD_NAME, cycle_counter);
+     } else {
+          printf("cpu: %s\n", cpu_model);
+          printf("field: %s, cycle counter: %s, %u runs\n"
+                 "%-30s %-8s %12s %12s %12s %12s %12s %12s\n",
+                 FIELD_NAME, cycle_counter, runs, "function",
+                 "impl", "median ns", "p90 ns", "p99 ns", "min ns",
+                 "median cyc", "p90 cyc");
+     }
+
+     for (size_t i = 0; i < sizeof(benchmarks)/sizeof(benchmarks[0]); i++) {
+          const benchmark *b = &benchmarks[i];
+          if (only_function != NULL && strstr(b->name, only_function) == NULL)
+               continue;
+          if (!b->per_implementation) {
+               crypto_scalarmult_curve25519_select(NULL);
+               measure(b, FIELD_NAME, ns, cyc);
+               continue;
+          }
+          for (int j = 0; j < nimpl; j++) {
+               crypto_scalarmult_curve25519_select(implementations[j]);
+               measure(b, implementations[j], ns, cyc);
+          }
+     }
+     crypto_scalarmult_curve25519_select(NULL);
+
+     if (json)
+          printf("\n]}\n");
+
+     free(ns);
+     free(cyc);
+     if (baseline != NULL && compare_baseline(baseline, threshold) > 0)
+          return 1;
+     return 0;
+}
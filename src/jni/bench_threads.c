@@ -0,0 +1,312 @@
+/**
+ * This file is part of ECDH-Curve25519-Mobile.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+
+/*
+ * Throughput of the key exchange with several threads. Every thread
+ * repeatedly does what one side of a handshake does: it derives a key pair
+ * from pre-generated random numbers and computes the shared secret with a
+ * pre-generated peer public key. The benchmark is run for each requested
+ * number of threads and reports the aggregate and per-thread handshakes per
+ * second as well as the latency percentiles of a single handshake over all
+ * threads. If the throughput does not grow linearly with the number of
+ * threads, there is shared state, false sharing, or frequency scaling.
+ *
+ * Usage: bench_threads [-t threads,...] [-d seconds] [-a] [-j]
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "ecdh_curve25519.h"
+
+#define INPUTS 64
+#define MAX_THREADS 256
+#define MAX_LATENCIES (1u << 20)
+#define CACHE_LINE 128
+
+/* Per-thread state; each thread only writes its own, cache-line aligned
+ * copy, so the threads do not share cache lines. */
+typedef struct {
+     pthread_t thread;
+     int index;
+     uint8_t random_number[INPUTS][ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t peer_public_key[INPUTS][ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t shared_secret[ECDH_CURVE25519_KEY_LENGTH];
+     unsigned long handshakes;
+     double seconds;
+     double *latency;
+     unsigned int nlatency;
+} __attribute__((aligned(CACHE_LINE))) worker;
+
+static double duration = 2.0;
+static int pin;
+static int json;
+static long ncpu;
+static pthread_barrier_t start_barrier;
+
+static uint64_t nanoseconds(void)
+{
+     struct timespec ts;
+     clock_gettime(CLOCK_MONOTONIC, &ts);
+     return (uint64_t) ts.tv_sec*1000000000 + ts.tv_nsec;
+}
+
+static void create_random_number(uint64_t *state, uint8_t *random_number,
+                                 size_t len)
+{
+     for (size_t i = 0; i < len; i++) {
+          *state ^= *state << 13;
+          *state ^= *state >> 7;
+          *state ^= *state << 17;
+          random_number[i] = (uint8_t) (*state >> 24);
+     }
+}
+
+static void worker_init(worker *w, int index)
+{
+     uint64_t state = 0x9e3779b97f4a7c15ULL + (uint64_t) index;
+     uint8_t secret_key[ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t random_number[ECDH_CURVE25519_KEY_LENGTH];
+
+     w->index = index;
+     for (int i = 0; i < INPUTS; i++) {
+          create_random_number(&state, w->random_number[i],
+                               ECDH_CURVE25519_KEY_LENGTH);
+          create_random_number(&state, random_number, sizeof(random_number));
+          ecdh_curve25519_secret_key(secret_key, random_number);
+          ecdh_curve25519_public_key(w->peer_public_key[i], secret_key);
+     }
+}
+
+static void *worker_run(void *arg)
+{
+     worker *w = (worker *) arg;
+     uint8_t secret_key[ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t public_key[ECDH_CURVE25519_KEY_LENGTH];
+     unsigned long n = 0;
+
+     if (pin) {
+          cpu_set_t set;
+          CPU_ZERO(&set);
+          CPU_SET(w->index % ncpu, &set);
+          pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+     }
+
+     pthread_barrier_wait(&start_barrier);
+     uint64_t start = nanoseconds();
+     uint64_t end = start + (uint64_t) (duration*1e9);
+     uint64_t now = start;
+     while (now < end) {
+          int i = n % INPUTS;
+          ecdh_curve25519_secret_key(secret_key, w->random_number[i]);
+          ecdh_curve25519_public_key(public_key, secret_key);
+          ecdh_curve25519_shared_secret(w->shared_secret, secret_key,
+                                        w->peer_public_key[i]);
+          uint64_t t = nanoseconds();
+          if (w->nlatency < MAX_LATENCIES)
+               w->latency[w->nlatency++] = (double) (t - now);
+          now = t;
+          n++;
+     }
+     w->handshakes = n;
+     w->seconds = (double) (now - start)/1e9;
+     return NULL;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+     double x = *(const double *) a;
+     double y = *(const double *) b;
+     return (x > y) - (x < y);
+}
+
+static double percentile(const double *v, unsigned int n, unsigned int p)
+{
+     return v[(n*p + 99)/100 - 1];
+}
+
+static int run(worker *workers, int nthreads, int first)
+{
+     pthread_barrier_init(&start_barrier, NULL, (unsigned int) nthreads);
+     for (int i = 0; i < nthreads; i++) {
+          workers[i].nlatency = 0;
+          int err = pthread_create(&workers[i].thread, NULL, worker_run,
+                                   &workers[i]);
+          if (err != 0) {
+               fprintf(stderr, "cannot create thread: %s\n", strerror(err));
+               exit(1);
+          }
+     }
+     for (int i = 0; i < nthreads; i++)
+          pthread_join(workers[i].thread, NULL);
+     pthread_barrier_destroy(&start_barrier);
+
+     double total = 0, min_rate = 0, max_rate = 0;
+     unsigned int nlatency = 0;
+     for (int i = 0; i < nthreads; i++) {
+          double rate = workers[i].handshakes/workers[i].seconds;
+          total += rate;
+          if (i == 0 || rate < min_rate)
+               min_rate = rate;
+          if (i == 0 || rate > max_rate)
+               max_rate = rate;
+          nlatency += workers[i].nlatency;
+     }
+
+     double *latency = malloc(nlatency*sizeof(double));
+     if (latency == NULL) {
+          fprintf(stderr, "out of memory\n");
+          exit(1);
+     }
+     nlatency = 0;
+     for (int i = 0; i < nthreads; i++) {
+          memcpy(latency + nlatency, workers[i].latency,
+                 workers[i].nlatency*sizeof(double));
+          nlatency += workers[i].nlatency;
+     }
+     qsort(latency, nlatency, sizeof(double), compare_double);
+
+     if (json)
+          printf("%s\n    {\"threads\": %d, \"handshakes_per_second\": %.1f, "
+                 "\"per_thread\": {\"mean\": %.1f, \"min\": %.1f, "
+                 "\"max\": %.1f},\n     \"latency_us\": {\"median\": %.2f, "
+                 "\"p90\": %.2f, \"p99\": %.2f, \"p999\": %.2f, "
+                 "\"max\": %.2f}}",
+                 first ? "" : ",", nthreads, total, total/nthreads, min_rate,
+                 max_rate, latency[(nlatency - 1)/2]/1e3,
+                 percentile(latency, nlatency, 90)/1e3,
+                 percentile(latency, nlatency, 99)/1e3,
+                 latency[((size_t) nlatency*999 + 999)/1000 - 1]/1e3,
+                 latency[nlatency - 1]/1e3);
+     else
+          printf("%7d %12.0f %12.0f %12.0f %10.1f %10.1f %10.1f %10.1f\n",
+                 nthreads, total, total/nthreads, min_rate,
+                 latency[(nlatency - 1)/2]/1e3,
+                 percentile(latency, nlatency, 90)/1e3,
+                 percentile(latency, nlatency, 99)/1e3,
+                 latency[((size_t) nlatency*999 + 999)/1000 - 1]/1e3);
+     free(latency);
+     return 0;
+}
+
+static void usage(const char *prog)
+{
+     fprintf(stderr,
+             "usage: %s [-t threads,...] [-d seconds] [-a] [-j]\n"
+             "  -t threads  comma-separated thread counts (default 1,2,4,..."
+             " up to the number of CPUs)\n"
+             "  -d seconds  duration of each run (default %.1f)\n"
+             "  -a          pin thread i to CPU i modulo the number of CPUs\n"
+             "  -j          JSON output\n",
+             prog, duration);
+}
+
+int main(int argc, char *argv[])
+{
+     int counts[64];
+     int ncounts = 0;
+     int max_threads = 0;
+     int opt;
+
+     ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+     if (ncpu < 1)
+          ncpu = 1;
+
+     while ((opt = getopt(argc, argv, "t:d:ajh")) != -1) {
+          switch (opt) {
+          case 't':
+               for (char *s = strtok(optarg, ","); s != NULL && ncounts < 64;
+                    s = strtok(NULL, ","))
+                    counts[ncounts++] = atoi(s);
+               break;
+          case 'd': duration = atof(optarg); break;
+          case 'a': pin = 1; break;
+          case 'j': json = 1; break;
+          default: usage(argv[0]); return 2;
+          }
+     }
+     if (ncounts == 0) {
+          for (int t = 1; t < ncpu && ncounts < 63; t *= 2)
+               counts[ncounts++] = t;
+          counts[ncounts++] = (int) ncpu;
+     }
+     for (int i = 0; i < ncounts; i++) {
+          if (counts[i] < 1 || counts[i] > MAX_THREADS || duration <= 0) {
+               usage(argv[0]);
+               return 2;
+          }
+          if (counts[i] > max_threads)
+               max_threads = counts[i];
+     }
+
+     worker *workers = aligned_alloc(CACHE_LINE, max_threads*sizeof(worker));
+     if (workers == NULL) {
+          fprintf(stderr, "out of memory\n");
+          return 1;
+     }
+     for (int i = 0; i < max_threads; i++) {
+          worker_init(&workers[i], i);
+          workers[i].latency = malloc(MAX_LATENCIES*sizeof(double));
+          if (workers[i].latency == NULL) {
+               fprintf(stderr, "out of memory\n");
+               return 1;
+          }
+     }
+
+     if (json)
+          printf("{\"implementation\": \"%s\", \"cpus\": %ld, "
+                 "\"pinned\": %s, \"seconds\": %.1f, \"results\": [",
+                 ecdh_curve25519_implementation(), ncpu,
+                 pin ? "true" : "false", duration);
+     else
+          printf("implementation: %s, %ld CPUs, %.1f s per run%s\n"
+                 "%7s %12s %12s %12s %10s %10s %10s %10s\n",
+                 ecdh_curve25519_implementation(), ncpu, duration,
+                 pin ? ", pinned" : "", "threads", "total/s", "thread/s",
+                 "min thr/s", "p50 us", "p90 us", "p99 us", "p99.9 us");
+
+     for (int i = 0; i < ncounts; i++)
+          run(workers, counts[i], i == 0);
+
+     if (json)
+          printf("\n]}\n");
+
+     for (int i = 0; i < max_threads; i++)
+          free(workers[i].latency);
+     free(workers);
+     return 0;
+}
@@ -3,6 +3,8 @@
  * Author:  Michael Hutter, Peter Schwabe
  * Version: Tue Aug 12 08:23:16 2014 +0200
  * Public Domain
+ *
+ * Modifications: added bigint_square32.
  */
 
 #include "avrnacl.h"
@@ -51,6 +53,35 @@ void bigint_mul(unsigned char *r, const unsigned char *a, const unsigned char *b
   }
 }
 
+/* r = a^2: every cross product is computed once and doubled */
+static void bigint_square(unsigned char *r, const unsigned char *a, unsigned int len) 
+{
+  unsigned int i,j;
+  crypto_uint16 t, d;
+  for(i=0;i<2*len;i++)
+    r[i] = 0;
+
+  for (i=0; i<len; i++) {
+    t = 0;
+    for (j=i+1; j<len; j++) {
+      t=r[i+j]+a[i]*a[j] + (t>>8);
+      r[i+j]=(t & 0xFF);
+    }
+    r[i+len]=(t>>8);
+  }
+
+  t = 0;
+  for (i=0; i<len; i++) {
+    d = a[i]*a[i];
+    t += (r[2*i] << 1) + (d & 0xFF);
+    r[2*i] = (t & 0xFF);
+    t >>= 8;
+    t += (r[2*i+1] << 1) + (d >> 8);
+    r[2*i+1] = (t & 0xFF);
+    t >>= 8;
+  }
+}
+
 static void bigint_mul16c(unsigned char r[34], const unsigned char a[17], const unsigned char b[17]) 
 {
   unsigned char t0[9], t1[9],t[18], i;
@@ -117,6 +148,70 @@ void bigint_mul32(unsigned char *r, const unsigned char *a, const unsigned char
   }
 }
 
+static void bigint_square16c(unsigned char r[34], const unsigned char a[17]) 
+{
+  unsigned char t0[9], t[18], i;
+  int u;
+  bigint_square(r, a, 8);
+  bigint_square(r+16, a+8, 9);
+
+  t0[8] = a[16] + bigint_add(t0,a,a+8,8);
+  bigint_square(t,t0,9);
+  t[17] -= bigint_sub(t,t,r+16,17);
+  u = t[16];
+  u -= bigint_sub(t,t,r,16);
+  t[16] = u & 0xff;
+  u>>=15;
+  t[17] -= u;
+  u = bigint_add(r+8,r+8,t,17);
+  for(i=25;i<34;i++)
+  {
+    u += r[i];
+    r[i] = u & 0xff;
+    u >>= 8;
+  }
+}
+
+static void bigint_square16(unsigned char r[32], const unsigned char a[16]) 
+{
+  unsigned char t0[9], t[18], i;
+  int u;
+  bigint_square(r, a, 8);
+  bigint_square(r+16, a+8, 8);
+  t0[8] = bigint_add(t0,a,a+8,8);
+  bigint_square(t,t0,9);
+  t[16] -= bigint_sub(t,t,r,16);
+  t[16] -= bigint_sub(t,t,r+16,16);
+  u = bigint_add(r+8,r+8,t,17);
+  for(i=25;i<32;i++)
+  {
+    u += r[i];
+    r[i] = u & 0xff;
+    u >>= 8;
+  }
+}
+
+/* Same Karatsuba structure as bigint_mul32 with
+ * (a0 + a1 X)^2 = a0^2 + ((a0+a1)^2 - a0^2 - a1^2) X + a1^2 X^2 */
+void bigint_square32(unsigned char *r, const unsigned char *a) 
+{
+  unsigned char t0[17], t[34], i;
+  int u;
+  bigint_square16(r, a);
+  bigint_square16(r+32, a+16);
+  t0[16] = bigint_add(t0,a,a+16,16);
+  bigint_square16c(t,t0);
+  t[32] -= bigint_sub(t,t,r,32);
+  t[32] -= bigint_sub(t,t,r+32,32);
+  u = bigint_add(r+16,r+16,t,33);
+  for(i=49;i<64;i++)
+  {
+    u += r[i];
+    r[i] = u & 0xff;
+    u >>= 8;
+  }
+}
+
 
 void bigint_cmov(unsigned char *r, const unsigned char *x, unsigned char b, unsigned int len)
 {
@@ -7,6 +7,8 @@
 
 #include "avrnacl.h"
 #include "fe25519.h"
+#include "curve25519_dispatch.h"
+#include "ge25519.h"
 
 static void work_cswap(fe25519 *work, char b)
 {
@@ -20,8 +22,6 @@ static void work_cswap(fe25519 *work, char b)
   fe25519_cmov(work+4, &t, b);
 }
 
-static const fe25519 _121666 = {{0x42, 0xDB, 0x01, 0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0}};
-
 static void ladderstep(fe25519 *work)
 {
   fe25519 t1,t2,t3,t4,t5,t6,t7;
@@ -30,27 +30,31 @@ static void ladderstep(fe25519 *work)
   fe25519 *zp = work+2;
   fe25519 *xq = work+3; 
   fe25519 *zq = work+4;
-  fe25519_add(&t1, xp, zp);
-  fe25519_sub(&t2, xp, zp); 
+  fe25519_add_nr(&t1, xp, zp);
+  fe25519_sub_nr(&t2, xp, zp); 
   fe25519_square(&t7, &t2);
   fe25519_square(&t6, &t1);
-  fe25519_sub(&t5,&t6,&t7);
-  fe25519_add(&t3, xq, zq); 
-  fe25519_sub(&t4, xq, zq);
+  fe25519_sub_nr(&t5,&t6,&t7);
+  fe25519_add_nr(&t3, xq, zq); 
+  fe25519_sub_nr(&t4, xq, zq);
   fe25519_mul(&t2,&t3,&t2);
   fe25519_mul(&t3,&t4,&t1);
-  fe25519_add(xq, &t3, &t2);
-  fe25519_sub(zq, &t3, &t2);
+  fe25519_add_nr(xq, &t3, &t2);
+  fe25519_sub_nr(zq, &t3, &t2);
   fe25519_square(xq, xq);
   fe25519_square(zq, zq);
   fe25519_mul(zq, zq, x0);
   fe25519_mul(xp, &t6, &t7);
-  //fe25519_mul121666(zp, &t5);
-  fe25519_mul(zp, &t5, &_121666);
-  fe25519_add(zp, zp, &t7);
+  fe25519_mul121666(zp, &t5);
+  fe25519_add_nr(zp, zp, &t7);
   fe25519_mul(zp, zp, &t5);
 }
 
+void crypto_scalarmult_curve25519_ladderstep(fe25519 work[5])
+{
+  ladderstep(work);
+}
+
 static void mladder(fe25519 *xr, fe25519 *zr, const unsigned char s[32])
 {
   fe25519 work[5];
@@ -84,35 +88,66 @@ static void mladder(fe25519 *xr, fe25519 *zr, const unsigned char s[32])
 }
 
 
-int crypto_scalarmult_curve25519(
-    unsigned char *r,
-    const unsigned char *s,
-    const unsigned char *p
-    )
+/* Ladder on the clamped scalar s; leaves the projective result in x, z */
+static void scalarmult_xz(fe25519 *x, fe25519 *z, const unsigned char *s, const unsigned char *p)
 {
   unsigned char e[32];
   unsigned char i;
+
   for(i=0;i<32;i++) e[i] = s[i];
   e[0] &= 248;
   e[31] &= 127;
   e[31] |= 64; 
 
+  fe25519_unpack(x, p);
+  mladder(x, z, e);
+}
+
+int crypto_scalarmult_curve25519_portable(
+    unsigned char *r,
+    const unsigned char *s,
+    const unsigned char *p
+    )
+{
   fe25519 t;
   fe25519 z;
-  fe25519_unpack(&t, p);
-  mladder(&t, &z, e);
+  scalarmult_xz(&t, &z, s, p);
   fe25519_invert(&z, &z);
   fe25519_mul(&t, &t, &z);
   fe25519_pack(r, &t);
   return 0;
 }
 
-static const unsigned char base[32] = {9};
+int crypto_scalarmult_curve25519_portable_xz(
+    unsigned char *x,
+    unsigned char *z,
+    const unsigned char *s,
+    const unsigned char *p
+    )
+{
+  fe25519 t;
+  fe25519 w;
+  scalarmult_xz(&t, &w, s, p);
+  fe25519_pack(x, &t);
+  fe25519_pack(z, &w);
+  return 0;
+}
 
-int crypto_scalarmult_curve25519_base(
-    unsigned char *q, 
+int crypto_scalarmult_curve25519_base_edwards(
+    unsigned char *q,
     const unsigned char *n
     )
 {
-  return crypto_scalarmult_curve25519(q,n,base);
+  unsigned char e[32];
+  unsigned char i;
+  ge25519_p3 r;
+
+  for(i=0;i<32;i++) e[i] = n[i];
+  e[0] &= 248;
+  e[31] &= 127;
+  e[31] |= 64;
+
+  ge25519_scalarmult_base(&r, e);
+  ge25519_pack_montgomery(q, &r);
+  return 0;
 }
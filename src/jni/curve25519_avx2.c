@@ -0,0 +1,495 @@
+/**
+ * This file is part of ECDH-Curve25519-Mobile.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+
+/*
+ * Four independent Curve25519 scalar multiplications with AVX2. Field
+ * elements of the four computations are stored structure-of-arrays: limb i
+ * of all four elements shares one 256-bit vector with one 64-bit lane per
+ * computation. Limbs are in radix 2^25.5 as in fe25519_radix25.c, so that
+ * VPMULUDQ computes four 32x32->64 bit limb products at once. The four
+ * ladders run in lockstep; the conditional swap uses a per-lane mask.
+ *
+ * This code must only be called if crypto_scalarmult_curve25519_avx2_supported()
+ * returns non-zero.
+ */
+
+#include "avrnacl.h"
+#include "fe25519.h"
+#include "curve25519_avx2.h"
+
+#if defined(CURVE25519_AVX2)
+
+#include <immintrin.h>
+
+#define AVX2 __attribute__((target("avx2")))
+
+#define MASK25 0x1ffffff
+#define MASK26 0x3ffffff
+
+typedef struct
+{
+  __m256i v[10];
+}
+fe25519x4;
+
+/* c*19 = c*16 + c*2 + c */
+#define MUL19(c) _mm256_add_epi64(_mm256_add_epi64(_mm256_slli_epi64(c, 4), _mm256_slli_epi64(c, 1)), c)
+
+/* Propagate carries once through all limbs, folding the top carry back
+ * into v[0] using 2^255 = 19 */
+static AVX2 void fe25519x4_carry(__m256i *h)
+{
+  const __m256i mask25 = _mm256_set1_epi64x(MASK25);
+  const __m256i mask26 = _mm256_set1_epi64x(MASK26);
+  __m256i c;
+  int i;
+
+  for(i=0;i<10;i+=2)
+  {
+    c = _mm256_srli_epi64(h[i], 26); h[i] = _mm256_and_si256(h[i], mask26); h[i+1] = _mm256_add_epi64(h[i+1], c);
+    c = _mm256_srli_epi64(h[i+1], 25); h[i+1] = _mm256_and_si256(h[i+1], mask25);
+    if(i < 8)
+      h[i+2] = _mm256_add_epi64(h[i+2], c);
+  }
+  h[0] = _mm256_add_epi64(h[0], MUL19(c));
+  c = _mm256_srli_epi64(h[0], 26); h[0] = _mm256_and_si256(h[0], mask26); h[1] = _mm256_add_epi64(h[1], c);
+}
+
+/* Addition and subtraction do not propagate carries: every result in the
+ * ladder step is only used as input of a multiplication, which accepts the
+ * larger limbs (see fe25519_add_nr in fe25519_radix25.c). */
+static AVX2 void fe25519x4_add(fe25519x4 *r, const fe25519x4 *x, const fe25519x4 *y)
+{
+  int i;
+  for(i=0;i<10;i++)
+    r->v[i] = _mm256_add_epi64(x->v[i], y->v[i]);
+}
+
+static AVX2 void fe25519x4_sub(fe25519x4 *r, const fe25519x4 *x, const fe25519x4 *y)
+{
+  /* Add 2p before subtracting to keep all limbs positive */
+  const __m256i p0 = _mm256_set1_epi64x(0x7ffffda);
+  const __m256i podd = _mm256_set1_epi64x(0x3fffffe);
+  const __m256i peven = _mm256_set1_epi64x(0x7fffffe);
+  int i;
+  r->v[0] = _mm256_sub_epi64(_mm256_add_epi64(x->v[0], p0), y->v[0]);
+  for(i=1;i<10;i++)
+    r->v[i] = _mm256_sub_epi64(_mm256_add_epi64(x->v[i], (i & 1) ? podd : peven), y->v[i]);
+}
+
+static AVX2 void fe25519x4_mul(fe25519x4 *r, const fe25519x4 *x, const fe25519x4 *y)
+{
+  __m256i x0 = x->v[0], x1 = x->v[1], x2 = x->v[2], x3 = x->v[3], x4 = x->v[4];
+  __m256i x5 = x->v[5], x6 = x->v[6], x7 = x->v[7], x8 = x->v[8], x9 = x->v[9];
+  __m256i y0 = y->v[0], y1 = y->v[1], y2 = y->v[2], y3 = y->v[3], y4 = y->v[4];
+  __m256i y5 = y->v[5], y6 = y->v[6], y7 = y->v[7], y8 = y->v[8], y9 = y->v[9];
+  __m256i x1_2 = _mm256_slli_epi64(x1, 1), x3_2 = _mm256_slli_epi64(x3, 1), x5_2 = _mm256_slli_epi64(x5, 1);
+  __m256i x7_2 = _mm256_slli_epi64(x7, 1), x9_2 = _mm256_slli_epi64(x9, 1);
+  __m256i y1_19 = MUL19(y1), y2_19 = MUL19(y2), y3_19 = MUL19(y3), y4_19 = MUL19(y4), y5_19 = MUL19(y5);
+  __m256i y6_19 = MUL19(y6), y7_19 = MUL19(y7), y8_19 = MUL19(y8), y9_19 = MUL19(y9);
+  __m256i *h = r->v;
+
+  h[0] = _mm256_mul_epu32(x0, y0);
+  h[0] = _mm256_add_epi64(h[0], _mm256_mul_epu32(x1_2, y9_19));
+  h[0] = _mm256_add_epi64(h[0], _mm256_mul_epu32(x2, y8_19));
+  h[0] = _mm256_add_epi64(h[0], _mm256_mul_epu32(x3_2, y7_19));
+  h[0] = _mm256_add_epi64(h[0], _mm256_mul_epu32(x4, y6_19));
+  h[0] = _mm256_add_epi64(h[0], _mm256_mul_epu32(x5_2, y5_19));
+  h[0] = _mm256_add_epi64(h[0], _mm256_mul_epu32(x6, y4_19));
+  h[0] = _mm256_add_epi64(h[0], _mm256_mul_epu32(x7_2, y3_19));
+  h[0] = _mm256_add_epi64(h[0], _mm256_mul_epu32(x8, y2_19));
+  h[0] = _mm256_add_epi64(h[0], _mm256_mul_epu32(x9_2, y1_19));
+  h[1] = _mm256_mul_epu32(x0, y1);
+  h[1] = _mm256_add_epi64(h[1], _mm256_mul_epu32(x1, y0));
+  h[1] = _mm256_add_epi64(h[1], _mm256_mul_epu32(x2, y9_19));
+  h[1] = _mm256_add_epi64(h[1], _mm256_mul_epu32(x3, y8_19));
+  h[1] = _mm256_add_epi64(h[1], _mm256_mul_epu32(x4, y7_19));
+  h[1] = _mm256_add_epi64(h[1], _mm256_mul_epu32(x5, y6_19));
+  h[1] = _mm256_add_epi64(h[1], _mm256_mul_epu32(x6, y5_19));
+  h[1] = _mm256_add_epi64(h[1], _mm256_mul_epu32(x7, y4_19));
+  h[1] = _mm256_add_epi64(h[1], _mm256_mul_epu32(x8, y3_19));
+  h[1] = _mm256_add_epi64(h[1], _mm256_mul_epu32(x9, y2_19));
+  h[2] = _mm256_mul_epu32(x0, y2);
+  h[2] = _mm256_add_epi64(h[2], _mm256_mul_epu32(x1_2, y1));
+  h[2] = _mm256_add_epi64(h[2], _mm256_mul_epu32(x2, y0));
+  h[2] = _mm256_add_epi64(h[2], _mm256_mul_epu32(x3_2, y9_19));
+  h[2] = _mm256_add_epi64(h[2], _mm256_mul_epu32(x4, y8_19));
+  h[2] = _mm256_add_epi64(h[2], _mm256_mul_epu32(x5_2, y7_19));
+  h[2] = _mm256_add_epi64(h[2], _mm256_mul_epu32(x6, y6_19));
+  h[2] = _mm256_add_epi64(h[2], _mm256_mul_epu32(x7_2, y5_19));
+  h[2] = _mm256_add_epi64(h[2], _mm256_mul_epu32(x8, y4_19));
+  h[2] = _mm256_add_epi64(h[2], _mm256_mul_epu32(x9_2, y3_19));
+  h[3] = _mm256_mul_epu32(x0, y3);
+  h[3] = _mm256_add_epi64(h[3], _mm256_mul_epu32(x1, y2));
+  h[3] = _mm256_add_epi64(h[3], _mm256_mul_epu32(x2, y1));
+  h[3] = _mm256_add_epi64(h[3], _mm256_mul_epu32(x3, y0));
+  h[3] = _mm256_add_epi64(h[3], _mm256_mul_epu32(x4, y9_19));
+  h[3] = _mm256_add_epi64(h[3], _mm256_mul_epu32(x5, y8_19));
+  h[3] = _mm256_add_epi64(h[3], _mm256_mul_epu32(x6, y7_19));
+  h[3] = _mm256_add_epi64(h[3], _mm256_mul_epu32(x7, y6_19));
+  h[3] = _mm256_add_epi64(h[3], _mm256_mul_epu32(x8, y5_19));
+  h[3] = _mm256_add_epi64(h[3], _mm256_mul_epu32(x9, y4_19));
+  h[4] = _mm256_mul_epu32(x0, y4);
+  h[4] = _mm256_add_epi64(h[4], _mm256_mul_epu32(x1_2, y3));
+  h[4] = _mm256_add_epi64(h[4], _mm256_mul_epu32(x2, y2));
+  h[4] = _mm256_add_epi64(h[4], _mm256_mul_epu32(x3_2, y1));
+  h[4] = _mm256_add_epi64(h[4], _mm256_mul_epu32(x4, y0));
+  h[4] = _mm256_add_epi64(h[4], _mm256_mul_epu32(x5_2, y9_19));
+  h[4] = _mm256_add_epi64(h[4], _mm256_mul_epu32(x6, y8_19));
+  h[4] = _mm256_add_epi64(h[4], _mm256_mul_epu32(x7_2, y7_19));
+  h[4] = _mm256_add_epi64(h[4], _mm256_mul_epu32(x8, y6_19));
+  h[4] = _mm256_add_epi64(h[4], _mm256_mul_epu32(x9_2, y5_19));
+  h[5] = _mm256_mul_epu32(x0, y5);
+  h[5] = _mm256_add_epi64(h[5], _mm256_mul_epu32(x1, y4));
+  h[5] = _mm256_add_epi64(h[5], _mm256_mul_epu32(x2, y3));
+  h[5] = _mm256_add_epi64(h[5], _mm256_mul_epu32(x3, y2));
+  h[5] = _mm256_add_epi64(h[5], _mm256_mul_epu32(x4, y1));
+  h[5] = _mm256_add_epi64(h[5], _mm256_mul_epu32(x5, y0));
+  h[5] = _mm256_add_epi64(h[5], _mm256_mul_epu32(x6, y9_19));
+  h[5] = _mm256_add_epi64(h[5], _mm256_mul_epu32(x7, y8_19));
+  h[5] = _mm256_add_epi64(h[5], _mm256_mul_epu32(x8, y7_19));
+  h[5] = _mm256_add_epi64(h[5], _mm256_mul_epu32(x9, y6_19));
+  h[6] = _mm256_mul_epu32(x0, y6);
+  h[6] = _mm256_add_epi64(h[6], _mm256_mul_epu32(x1_2, y5));
+  h[6] = _mm256_add_epi64(h[6], _mm256_mul_epu32(x2, y4));
+  h[6] = _mm256_add_epi64(h[6], _mm256_mul_epu32(x3_2, y3));
+  h[6] = _mm256_add_epi64(h[6], _mm256_mul_epu32(x4, y2));
+  h[6] = _mm256_add_epi64(h[6], _mm256_mul_epu32(x5_2, y1));
+  h[6] = _mm256_add_epi64(h[6], _mm256_mul_epu32(x6, y0));
+  h[6] = _mm256_add_epi64(h[6], _mm256_mul_epu32(x7_2, y9_19));
+  h[6] = _mm256_add_epi64(h[6], _mm256_mul_epu32(x8, y8_19));
+  h[6] = _mm256_add_epi64(h[6], _mm256_mul_epu32(x9_2, y7_19));
+  h[7] = _mm256_mul_epu32(x0, y7);
+  h[7] = _mm256_add_epi64(h[7], _mm256_mul_epu32(x1, y6));
+  h[7] = _mm256_add_epi64(h[7], _mm256_mul_epu32(x2, y5));
+  h[7] = _mm256_add_epi64(h[7], _mm256_mul_epu32(x3, y4));
+  h[7] = _mm256_add_epi64(h[7], _mm256_mul_epu32(x4, y3));
+  h[7] = _mm256_add_epi64(h[7], _mm256_mul_epu32(x5, y2));
+  h[7] = _mm256_add_epi64(h[7], _mm256_mul_epu32(x6, y1));
+  h[7] = _mm256_add_epi64(h[7], _mm256_mul_epu32(x7, y0));
+  h[7] = _mm256_add_epi64(h[7], _mm256_mul_epu32(x8, y9_19));
+  h[7] = _mm256_add_epi64(h[7], _mm256_mul_epu32(x9, y8_19));
+  h[8] = _mm256_mul_epu32(x0, y8);
+  h[8] = _mm256_add_epi64(h[8], _mm256_mul_epu32(x1_2, y7));
+  h[8] = _mm256_add_epi64(h[8], _mm256_mul_epu32(x2, y6));
+  h[8] = _mm256_add_epi64(h[8], _mm256_mul_epu32(x3_2, y5));
+  h[8] = _mm256_add_epi64(h[8], _mm256_mul_epu32(x4, y4));
+  h[8] = _mm256_add_epi64(h[8], _mm256_mul_epu32(x5_2, y3));
+  h[8] = _mm256_add_epi64(h[8], _mm256_mul_epu32(x6, y2));
+  h[8] = _mm256_add_epi64(h[8], _mm256_mul_epu32(x7_2, y1));
+  h[8] = _mm256_add_epi64(h[8], _mm256_mul_epu32(x8, y0));
+  h[8] = _mm256_add_epi64(h[8], _mm256_mul_epu32(x9_2, y9_19));
+  h[9] = _mm256_mul_epu32(x0, y9);
+  h[9] = _mm256_add_epi64(h[9], _mm256_mul_epu32(x1, y8));
+  h[9] = _mm256_add_epi64(h[9], _mm256_mul_epu32(x2, y7));
+  h[9] = _mm256_add_epi64(h[9], _mm256_mul_epu32(x3, y6));
+  h[9] = _mm256_add_epi64(h[9], _mm256_mul_epu32(x4, y5));
+  h[9] = _mm256_add_epi64(h[9], _mm256_mul_epu32(x5, y4));
+  h[9] = _mm256_add_epi64(h[9], _mm256_mul_epu32(x6, y3));
+  h[9] = _mm256_add_epi64(h[9], _mm256_mul_epu32(x7, y2));
+  h[9] = _mm256_add_epi64(h[9], _mm256_mul_epu32(x8, y1));
+  h[9] = _mm256_add_epi64(h[9], _mm256_mul_epu32(x9, y0));
+
+  fe25519x4_carry(h);
+}
+
+static AVX2 void fe25519x4_square(fe25519x4 *r, const fe25519x4 *x)
+{
+  __m256i x0 = x->v[0], x1 = x->v[1], x2 = x->v[2], x3 = x->v[3], x4 = x->v[4];
+  __m256i x5 = x->v[5], x6 = x->v[6], x7 = x->v[7], x8 = x->v[8], x9 = x->v[9];
+  __m256i x0_2 = _mm256_slli_epi64(x0, 1), x1_2 = _mm256_slli_epi64(x1, 1), x2_2 = _mm256_slli_epi64(x2, 1);
+  __m256i x3_2 = _mm256_slli_epi64(x3, 1), x4_2 = _mm256_slli_epi64(x4, 1), x5_2 = _mm256_slli_epi64(x5, 1);
+  __m256i x6_2 = _mm256_slli_epi64(x6, 1), x7_2 = _mm256_slli_epi64(x7, 1), x8_2 = _mm256_slli_epi64(x8, 1);
+  __m256i x9_2 = _mm256_slli_epi64(x9, 1);
+  __m256i x1_4 = _mm256_slli_epi64(x1, 2), x3_4 = _mm256_slli_epi64(x3, 2), x5_4 = _mm256_slli_epi64(x5, 2);
+  __m256i x7_4 = _mm256_slli_epi64(x7, 2);
+  __m256i x5_19 = MUL19(x5), x6_19 = MUL19(x6), x7_19 = MUL19(x7), x8_19 = MUL19(x8), x9_19 = MUL19(x9);
+  __m256i *h = r->v;
+
+  h[0] = _mm256_mul_epu32(x0, x0);
+  h[0] = _mm256_add_epi64(h[0], _mm256_mul_epu32(x1_4, x9_19));
+  h[0] = _mm256_add_epi64(h[0], _mm256_mul_epu32(x2_2, x8_19));
+  h[0] = _mm256_add_epi64(h[0], _mm256_mul_epu32(x3_4, x7_19));
+  h[0] = _mm256_add_epi64(h[0], _mm256_mul_epu32(x4_2, x6_19));
+  h[0] = _mm256_add_epi64(h[0], _mm256_mul_epu32(x5_2, x5_19));
+  h[1] = _mm256_mul_epu32(x0_2, x1);
+  h[1] = _mm256_add_epi64(h[1], _mm256_mul_epu32(x2_2, x9_19));
+  h[1] = _mm256_add_epi64(h[1], _mm256_mul_epu32(x3_2, x8_19));
+  h[1] = _mm256_add_epi64(h[1], _mm256_mul_epu32(x4_2, x7_19));
+  h[1] = _mm256_add_epi64(h[1], _mm256_mul_epu32(x5_2, x6_19));
+  h[2] = _mm256_mul_epu32(x0_2, x2);
+  h[2] = _mm256_add_epi64(h[2], _mm256_mul_epu32(x1_2, x1));
+  h[2] = _mm256_add_epi64(h[2], _mm256_mul_epu32(x3_4, x9_19));
+  h[2] = _mm256_add_epi64(h[2], _mm256_mul_epu32(x4_2, x8_19));
+  h[2] = _mm256_add_epi64(h[2], _mm256_mul_epu32(x5_4, x7_19));
+  h[2] = _mm256_add_epi64(h[2], _mm256_mul_epu32(x6, x6_19));
+  h[3] = _mm256_mul_epu32(x0_2, x3);
+  h[3] = _mm256_add_epi64(h[3], _mm256_mul_epu32(x1_2, x2));
+  h[3] = _mm256_add_epi64(h[3], _mm256_mul_epu32(x4_2, x9_19));
+  h[3] = _mm256_add_epi64(h[3], _mm256_mul_epu32(x5_2, x8_19));
+  h[3] = _mm256_add_epi64(h[3], _mm256_mul_epu32(x6_2, x7_19));
+  h[4] = _mm256_mul_epu32(x0_2, x4);
+  h[4] = _mm256_add_epi64(h[4], _mm256_mul_epu32(x1_4, x3));
+  h[4] = _mm256_add_epi64(h[4], _mm256_mul_epu32(x2, x2));
+  h[4] = _mm256_add_epi64(h[4], _mm256_mul_epu32(x5_4, x9_19));
+  h[4] = _mm256_add_epi64(h[4], _mm256_mul_epu32(x6_2, x8_19));
+  h[4] = _mm256_add_epi64(h[4], _mm256_mul_epu32(x7_2, x7_19));
+  h[5] = _mm256_mul_epu32(x0_2, x5);
+  h[5] = _mm256_add_epi64(h[5], _mm256_mul_epu32(x1_2, x4));
+  h[5] = _mm256_add_epi64(h[5], _mm256_mul_epu32(x2_2, x3));
+  h[5] = _mm256_add_epi64(h[5], _mm256_mul_epu32(x6_2, x9_19));
+  h[5] = _mm256_add_epi64(h[5], _mm256_mul_epu32(x7_2, x8_19));
+  h[6] = _mm256_mul_epu32(x0_2, x6);
+  h[6] = _mm256_add_epi64(h[6], _mm256_mul_epu32(x1_4, x5));
+  h[6] = _mm256_add_epi64(h[6], _mm256_mul_epu32(x2_2, x4));
+  h[6] = _mm256_add_epi64(h[6], _mm256_mul_epu32(x3_2, x3));
+  h[6] = _mm256_add_epi64(h[6], _mm256_mul_epu32(x7_4, x9_19));
+  h[6] = _mm256_add_epi64(h[6], _mm256_mul_epu32(x8, x8_19));
+  h[7] = _mm256_mul_epu32(x0_2, x7);
+  h[7] = _mm256_add_epi64(h[7], _mm256_mul_epu32(x1_2, x6));
+  h[7] = _mm256_add_epi64(h[7], _mm256_mul_epu32(x2_2, x5));
+  h[7] = _mm256_add_epi64(h[7], _mm256_mul_epu32(x3_2, x4));
+  h[7] = _mm256_add_epi64(h[7], _mm256_mul_epu32(x8_2, x9_19));
+  h[8] = _mm256_mul_epu32(x0_2, x8);
+  h[8] = _mm256_add_epi64(h[8], _mm256_mul_epu32(x1_4, x7));
+  h[8] = _mm256_add_epi64(h[8], _mm256_mul_epu32(x2_2, x6));
+  h[8] = _mm256_add_epi64(h[8], _mm256_mul_epu32(x3_4, x5));
+  h[8] = _mm256_add_epi64(h[8], _mm256_mul_epu32(x4, x4));
+  h[8] = _mm256_add_epi64(h[8], _mm256_mul_epu32(x9_2, x9_19));
+  h[9] = _mm256_mul_epu32(x0_2, x9);
+  h[9] = _mm256_add_epi64(h[9], _mm256_mul_epu32(x1_2, x8));
+  h[9] = _mm256_add_epi64(h[9], _mm256_mul_epu32(x2_2, x7));
+  h[9] = _mm256_add_epi64(h[9], _mm256_mul_epu32(x3_2, x6));
+  h[9] = _mm256_add_epi64(h[9], _mm256_mul_epu32(x4_2, x5));
+
+  fe25519x4_carry(h);
+}
+
+static AVX2 void fe25519x4_mul121666(fe25519x4 *r, const fe25519x4 *x)
+{
+  const __m256i c = _mm256_set1_epi64x(121666);
+  int i;
+  for(i=0;i<10;i++)
+    r->v[i] = _mm256_mul_epu32(x->v[i], c);
+  fe25519x4_carry(r->v);
+}
+
+static AVX2 void work_cswap(fe25519x4 *work, __m256i mask)
+{
+  __m256i t;
+  int i;
+  for(i=0;i<10;i++)
+  {
+    t = _mm256_and_si256(mask, _mm256_xor_si256(work[1].v[i], work[3].v[i]));
+    work[1].v[i] = _mm256_xor_si256(work[1].v[i], t);
+    work[3].v[i] = _mm256_xor_si256(work[3].v[i], t);
+    t = _mm256_and_si256(mask, _mm256_xor_si256(work[2].v[i], work[4].v[i]));
+    work[2].v[i] = _mm256_xor_si256(work[2].v[i], t);
+    work[4].v[i] = _mm256_xor_si256(work[4].v[i], t);
+  }
+}
+
+static AVX2 void ladderstep(fe25519x4 *work)
+{
+  fe25519x4 t1,t2,t3,t4,t5,t6,t7;
+  fe25519x4 *x0 = work;
+  fe25519x4 *xp = work+1;
+  fe25519x4 *zp = work+2;
+  fe25519x4 *xq = work+3;
+  fe25519x4 *zq = work+4;
+  fe25519x4_add(&t1, xp, zp);
+  fe25519x4_sub(&t2, xp, zp);
+  fe25519x4_square(&t7, &t2);
+  fe25519x4_square(&t6, &t1);
+  fe25519x4_sub(&t5,&t6,&t7);
+  fe25519x4_add(&t3, xq, zq);
+  fe25519x4_sub(&t4, xq, zq);
+  fe25519x4_mul(&t2,&t3,&t2);
+  fe25519x4_mul(&t3,&t4,&t1);
+  fe25519x4_add(xq, &t3, &t2);
+  fe25519x4_sub(zq, &t3, &t2);
+  fe25519x4_square(xq, xq);
+  fe25519x4_square(zq, zq);
+  fe25519x4_mul(zq, zq, x0);
+  fe25519x4_mul(xp, &t6, &t7);
+  fe25519x4_mul121666(zp, &t5);
+  fe25519x4_add(zp, zp, &t7);
+  fe25519x4_mul(zp, zp, &t5);
+}
+
+static crypto_uint32 load32(const unsigned char *x)
+{
+  return (crypto_uint32)x[0] | ((crypto_uint32)x[1] << 8) | ((crypto_uint32)x[2] << 16) | ((crypto_uint32)x[3] << 24);
+}
+
+static AVX2 void fe25519x4_unpack(fe25519x4 *r, const unsigned char p[4][32])
+{
+  crypto_uint64 u[4][10];
+  int k;
+
+  for(k=0;k<4;k++)
+  {
+    u[k][0] = load32(p[k]) & MASK26;
+    u[k][1] = (load32(p[k]+3) >> 2) & MASK25;
+    u[k][2] = (load32(p[k]+6) >> 3) & MASK26;
+    u[k][3] = (load32(p[k]+9) >> 5) & MASK25;
+    u[k][4] = (load32(p[k]+12) >> 6) & MASK26;
+    u[k][5] = load32(p[k]+16) & MASK25;
+    u[k][6] = (load32(p[k]+19) >> 1) & MASK26;
+    u[k][7] = (load32(p[k]+22) >> 3) & MASK25;
+    u[k][8] = (load32(p[k]+25) >> 4) & MASK26;
+    u[k][9] = (load32(p[k]+28) >> 6) & MASK25;
+  }
+  for(k=0;k<10;k++)
+    r->v[k] = _mm256_set_epi64x(u[3][k], u[2][k], u[1][k], u[0][k]);
+}
+
+/* Convert the four elements of x to byte strings representing values
+ * below 2^255, which fe25519_unpack accepts */
+static AVX2 void fe25519x4_pack(unsigned char r[4][32], fe25519x4 *x)
+{
+  crypto_uint64 u[10][4], acc;
+  int bits, i, j, k;
+
+  fe25519x4_carry(x->v);
+  fe25519x4_carry(x->v);
+  for(i=0;i<10;i++)
+    _mm256_storeu_si256((__m256i *)u[i], x->v[i]);
+  for(k=0;k<4;k++)
+  {
+    acc = 0;
+    bits = 0;
+    j = 0;
+    for(i=0;i<10;i++)
+    {
+      acc |= u[i][k] << bits;
+      bits += (i & 1) ? 25 : 26;
+      while(bits >= 8)
+      {
+        r[k][j++] = acc & 0xff;
+        acc >>= 8;
+        bits -= 8;
+      }
+    }
+    r[k][j] = acc & 0xff;
+  }
+}
+
+static AVX2 void mladder_x4(unsigned char xr[4][32], unsigned char zr[4][32], const unsigned char p[4][32], const unsigned char e[4][32])
+{
+  fe25519x4 work[5];
+  crypto_uint64 bit[4], prevbit[4] = {0,0,0,0};
+  __m256i swap;
+  int i,k;
+
+  fe25519x4_unpack(work, p);
+  for(k=0;k<10;k++)
+  {
+    work[1].v[k] = _mm256_set1_epi64x(k == 0);
+    work[2].v[k] = _mm256_setzero_si256();
+    work[3].v[k] = work[0].v[k];
+    work[4].v[k] = work[1].v[k];
+  }
+
+  for(i=254;i>=0;i--)
+  {
+    for(k=0;k<4;k++)
+    {
+      bit[k] = 1&(e[k][i>>3]>>(i&7));
+      prevbit[k] ^= bit[k];
+    }
+    swap = _mm256_sub_epi64(_mm256_setzero_si256(), _mm256_set_epi64x(prevbit[3], prevbit[2], prevbit[1], prevbit[0]));
+    work_cswap(work, swap);
+    ladderstep(work);
+    for(k=0;k<4;k++)
+      prevbit[k] = bit[k];
+  }
+  fe25519x4_pack(xr, work+1);
+  fe25519x4_pack(zr, work+2);
+}
+
+int crypto_scalarmult_curve25519_avx2_supported(void)
+{
+  /* Checked once; concurrent first calls store the same value */
+  static int supported = -1;
+  int r = __atomic_load_n(&supported, __ATOMIC_RELAXED);
+  if(r < 0)
+  {
+    __builtin_cpu_init();
+    r = __builtin_cpu_supports("avx2") ? 1 : 0;
+    __atomic_store_n(&supported, r, __ATOMIC_RELAXED);
+  }
+  return r;
+}
+
+int crypto_scalarmult_curve25519_avx2_x4_xz(
+    unsigned char x[4][32],
+    unsigned char z[4][32],
+    const unsigned char s[4][32],
+    const unsigned char p[4][32]
+    )
+{
+  unsigned char e[4][32];
+  int i,k;
+
+  for(k=0;k<4;k++)
+  {
+    for(i=0;i<32;i++) e[k][i] = s[k][i];
+    e[k][0] &= 248;
+    e[k][31] &= 127;
+    e[k][31] |= 64;
+  }
+
+  mladder_x4(x, z, p, (const unsigned char (*)[32])e);
+  return 0;
+}
+
+int crypto_scalarmult_curve25519_avx2_x4(
+    unsigned char r[4][32],
+    const unsigned char s[4][32],
+    const unsigned char p[4][32]
+    )
+{
+  unsigned char xb[4][32], zb[4][32];
+  fe25519 t, z;
+  int k;
+
+  crypto_scalarmult_curve25519_avx2_x4_xz(xb, zb, s, p);
+  for(k=0;k<4;k++)
+  {
+    fe25519_unpack(&t, xb[k]);
+    fe25519_unpack(&z, zb[k]);
+    fe25519_invert(&z, &z);
+    fe25519_mul(&t, &t, &z);
+    fe25519_pack(r[k], &t);
+  }
+  return 0;
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef CURVE25519_AVX2_H
+#define CURVE25519_AVX2_H
+
+/* Four Curve25519 scalar multiplications at once with AVX2
+ * (curve25519_avx2.c). Only the functions in that file are compiled for
+ * AVX2, the CPU is checked at run time. */
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+  #define CURVE25519_AVX2
+#endif
+
+int crypto_scalarmult_curve25519_avx2_supported(void);
+
+/* Computes r[k] = s[k]*p[k] for k = 0,...,3 */
+int crypto_scalarmult_curve25519_avx2_x4(unsigned char r[4][32], const unsigned char s[4][32], const unsigned char p[4][32]);
+
+/* The projective results X[k], Z[k] of the four ladders, without the final
+ * inversions */
+int crypto_scalarmult_curve25519_avx2_x4_xz(unsigned char x[4][32], unsigned char z[4][32], const unsigned char s[4][32], const unsigned char p[4][32]);
+
+#endif
@@ -0,0 +1,107 @@
+/**
+ * This file is part of ECDH-Curve25519-Mobile.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+
+/*
+ * Batch scalar multiplication. The ladders return projective results
+ * X, Z; the Z of a whole chunk are then inverted at once with
+ * fe25519_batch_invert, which replaces all but one of the field inversions
+ * by three multiplications each. On CPUs with AVX2 the ladders run four at
+ * a time.
+ *
+ * Z is zero if and only if the result is the point at infinity (low-order
+ * input points), for which crypto_scalarmult_curve25519 returns 0. Such Z
+ * are replaced by 1 before the inversion and the result is set to 0
+ * afterwards, without branching on secret data.
+ */
+
+#include "avrnacl.h"
+#include "fe25519.h"
+#include "curve25519_dispatch.h"
+#include "curve25519_avx2.h"
+
+/* Inputs normalized with one inversion. Larger chunks save little more
+ * and cost stack space. */
+#define CHUNK 32
+
+static void batch_chunk(
+    unsigned char r[][32],
+    const unsigned char s[][32],
+    const unsigned char p[][32],
+    unsigned int n
+    )
+{
+  unsigned char xb[CHUNK][32], zb[CHUNK][32];
+  unsigned char zero[CHUNK];
+  fe25519 x[CHUNK], z[CHUNK], tmp[CHUNK];
+  fe25519 one, t;
+  unsigned int i = 0;
+
+#if defined(CURVE25519_AVX2)
+  if(crypto_scalarmult_curve25519_avx2_supported())
+  {
+    for(;i+4<=n;i+=4)
+      crypto_scalarmult_curve25519_avx2_x4_xz(xb+i, zb+i, s+i, p+i);
+  }
+#endif
+  for(;i<n;i++)
+    crypto_scalarmult_curve25519_xz(xb[i], zb[i], s[i], p[i]);
+
+  fe25519_setone(&one);
+  for(i=0;i<n;i++)
+  {
+    fe25519_unpack(&x[i], xb[i]);
+    fe25519_unpack(&z[i], zb[i]);
+    zero[i] = fe25519_iszero(&z[i]);
+    fe25519_cmov(&z[i], &one, zero[i]);
+  }
+
+  fe25519_batch_invert(z, z, tmp, n);
+
+  fe25519_setzero(&t);
+  for(i=0;i<n;i++)
+  {
+    fe25519_mul(&x[i], &x[i], &z[i]);
+    fe25519_cmov(&x[i], &t, zero[i]);
+    fe25519_pack(r[i], &x[i]);
+  }
+}
+
+int crypto_scalarmult_curve25519_batch(
+    unsigned char r[][32],
+    const unsigned char s[][32],
+    const unsigned char p[][32],
+    unsigned long long n
+    )
+{
+  unsigned long long i;
+
+  for(i=0;i<n;i+=CHUNK)
+    batch_chunk(r+i, s+i, p+i, (n-i < CHUNK) ? (unsigned int)(n-i) : CHUNK);
+  return 0;
+}
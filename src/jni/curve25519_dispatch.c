@@ -0,0 +1,160 @@
+/**
+ * This file is part of ECDH-Curve25519-Mobile.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+
+/*
+ * crypto_scalarmult_curve25519 and crypto_scalarmult_curve25519_base
+ * forward to one entry of the table below, bound through a pointer on
+ * first use. The table lists the implementations compiled for this target,
+ * fastest first; the first one the CPU supports is chosen. The portable
+ * ladder is always last and always supported. Fixed-base scalar
+ * multiplication uses the precomputed Edwards table on every target; it
+ * needs less than half of the field operations of a ladder.
+ */
+
+#include <string.h>
+
+#include "avrnacl.h"
+#include "fe25519.h"
+#include "curve25519_dispatch.h"
+
+typedef struct
+{
+  const char *name;
+  int (*supported)(void);
+  int (*scalarmult)(unsigned char *r, const unsigned char *s, const unsigned char *p);
+  int (*scalarmult_xz)(unsigned char *x, unsigned char *z, const unsigned char *s, const unsigned char *p);
+}
+curve25519_impl;
+
+static int always_supported(void)
+{
+  return 1;
+}
+
+static const curve25519_impl impls[] = {
+#if defined(CURVE25519_MULX)
+  {"mulx", crypto_scalarmult_curve25519_mulx_supported, crypto_scalarmult_curve25519_mulx, crypto_scalarmult_curve25519_mulx_xz},
+#endif
+#if defined(FE25519_RADIX51)
+  {"radix51", always_supported, crypto_scalarmult_curve25519_portable, crypto_scalarmult_curve25519_portable_xz},
+#elif defined(FE25519_RADIX25)
+  {"radix25", always_supported, crypto_scalarmult_curve25519_portable, crypto_scalarmult_curve25519_portable_xz},
+#else
+  {"radix8", always_supported, crypto_scalarmult_curve25519_portable, crypto_scalarmult_curve25519_portable_xz},
+#endif
+};
+
+#define NIMPLS (sizeof(impls) / sizeof(impls[0]))
+
+/* NULL until the first call. Resolving is idempotent, so concurrent first
+ * calls at worst all do the detection and store the same value. */
+static const curve25519_impl *impl;
+
+static const curve25519_impl *resolve(void)
+{
+  const curve25519_impl *r = __atomic_load_n(&impl, __ATOMIC_ACQUIRE);
+  unsigned int i;
+
+  if(r == 0)
+  {
+    for(i=0;i<NIMPLS;i++)
+    {
+      if(impls[i].supported())
+        break;
+    }
+    r = &impls[i];
+    __atomic_store_n(&impl, r, __ATOMIC_RELEASE);
+  }
+  return r;
+}
+
+int crypto_scalarmult_curve25519(
+    unsigned char *r,
+    const unsigned char *s,
+    const unsigned char *p
+    )
+{
+  return resolve()->scalarmult(r,s,p);
+}
+
+int crypto_scalarmult_curve25519_xz(
+    unsigned char *x,
+    unsigned char *z,
+    const unsigned char *s,
+    const unsigned char *p
+    )
+{
+  return resolve()->scalarmult_xz(x,z,s,p);
+}
+
+int crypto_scalarmult_curve25519_base(
+    unsigned char *q, 
+    const unsigned char *n
+    )
+{
+  return crypto_scalarmult_curve25519_base_edwards(q,n);
+}
+
+const char *crypto_scalarmult_curve25519_implementation(void)
+{
+  return resolve()->name;
+}
+
+const char *crypto_scalarmult_curve25519_implementation_name(int i)
+{
+  unsigned int j;
+
+  for(j=0;j<NIMPLS;j++)
+  {
+    if(impls[j].supported() && i-- == 0)
+      return impls[j].name;
+  }
+  return 0;
+}
+
+int crypto_scalarmult_curve25519_select(const char *name)
+{
+  unsigned int i;
+
+  if(name == 0)
+  {
+    __atomic_store_n(&impl, (const curve25519_impl *)0, __ATOMIC_RELEASE);
+    resolve();
+    return 0;
+  }
+  for(i=0;i<NIMPLS;i++)
+  {
+    if(strcmp(impls[i].name, name) == 0 && impls[i].supported())
+    {
+      __atomic_store_n(&impl, &impls[i], __ATOMIC_RELEASE);
+      return 0;
+    }
+  }
+  return -1;
+}
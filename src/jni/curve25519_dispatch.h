@@ -0,0 +1,48 @@
+#ifndef CURVE25519_DISPATCH_H
+#define CURVE25519_DISPATCH_H
+
+/* Run-time selection of the Curve25519 implementation
+ * (curve25519_dispatch.c). crypto_scalarmult_curve25519 calls the fastest
+ * implementation the CPU supports. The CPU is checked once, on first use.
+ * crypto_scalarmult_curve25519_base always uses
+ * crypto_scalarmult_curve25519_base_edwards. */
+
+#include "fe25519.h"
+#include "curve25519_mulx.h"
+
+/* The generic Montgomery ladder on top of fe25519 (curve25519.c) */
+int crypto_scalarmult_curve25519_portable(unsigned char *r, const unsigned char *s, const unsigned char *p);
+int crypto_scalarmult_curve25519_portable_xz(unsigned char *x, unsigned char *z, const unsigned char *s, const unsigned char *p);
+
+/* One step of the ladder of crypto_scalarmult_curve25519_portable on
+ * work = {x1, x2, z2, x3, z3}; exported for benchmarking (curve25519.c) */
+void crypto_scalarmult_curve25519_ladderstep(fe25519 work[5]);
+
+/* Fixed-base scalar multiplication on the equivalent Edwards curve with a
+ * precomputed table (curve25519.c, ge25519_base.c) */
+int crypto_scalarmult_curve25519_base_edwards(unsigned char *q, const unsigned char *n);
+
+/* Like crypto_scalarmult_curve25519, but returns the projective result
+ * X, Z of the ladder (as 32-byte strings for fe25519_unpack) instead of
+ * X/Z. Used by crypto_scalarmult_curve25519_batch. */
+int crypto_scalarmult_curve25519_xz(unsigned char *x, unsigned char *z, const unsigned char *s, const unsigned char *p);
+
+/* r[i] = s[i]*p[i] for 0 <= i < n. The results are normalized with one
+ * field inversion per chunk of inputs instead of one per input
+ * (curve25519_batch.c). */
+int crypto_scalarmult_curve25519_batch(unsigned char r[][32], const unsigned char s[][32], const unsigned char p[][32], unsigned long long n);
+
+/* Name of the implementation in use, e.g. "mulx" or "radix51" */
+const char *crypto_scalarmult_curve25519_implementation(void);
+
+/* Name of the i-th implementation supported by this CPU, or NULL if there
+ * are less than i+1 of them. Index 0 is the one chosen by default. */
+const char *crypto_scalarmult_curve25519_implementation_name(int i);
+
+/* Use the implementation with the given name, or the default one if name
+ * is NULL. Returns 0 on success and -1 if there is no such implementation
+ * or the CPU does not support it. Meant for testing and benchmarking; must
+ * not be called concurrently with scalar multiplications. */
+int crypto_scalarmult_curve25519_select(const char *name);
+
+#endif
@@ -0,0 +1,225 @@
+#ifndef CURVE25519_FE4_H
+#define CURVE25519_FE4_H
+
+/*
+ * Montgomery ladder on field elements in 4 saturated 64-bit words, i.e.,
+ * integers in [0,2^256) congruent to the represented value modulo 2^255-19.
+ * The ladder, inversion and packing are plain C. The file is included by the
+ * backend that provides the field arithmetic (curve25519_mulx.c), which has
+ * to define the static functions declared below.
+ */
+
+#include "avrnacl.h"
+
+typedef struct
+{
+  crypto_uint64 v[4];
+}
+fe4;
+
+static void fe4_add(fe4 *r, const fe4 *a, const fe4 *b);
+static void fe4_sub(fe4 *r, const fe4 *a, const fe4 *b);
+static void fe4_mul(fe4 *r, const fe4 *a, const fe4 *b);
+static void fe4_square(fe4 *r, const fe4 *a);
+static void fe4_mul121666(fe4 *r, const fe4 *a);
+
+static void fe4_invert(fe4 *r, const fe4 *x)
+{
+  fe4 z2, z9, z11, z2_5_0, z2_10_0, z2_20_0, z2_50_0, z2_100_0, t;
+  int i;
+
+  /* 2 */ fe4_square(&z2,x);
+  /* 4 */ fe4_square(&t,&z2);
+  /* 8 */ fe4_square(&t,&t);
+  /* 9 */ fe4_mul(&z9,&t,x);
+  /* 11 */ fe4_mul(&z11,&z9,&z2);
+  /* 22 */ fe4_square(&t,&z11);
+  /* 2^5 - 2^0 = 31 */ fe4_mul(&z2_5_0,&t,&z9);
+
+  /* 2^10 - 2^5 */ fe4_square(&t,&z2_5_0); for (i = 1;i < 5;i++) { fe4_square(&t,&t); }
+  /* 2^10 - 2^0 */ fe4_mul(&z2_10_0,&t,&z2_5_0);
+
+  /* 2^20 - 2^10 */ fe4_square(&t,&z2_10_0); for (i = 1;i < 10;i++) { fe4_square(&t,&t); }
+  /* 2^20 - 2^0 */ fe4_mul(&z2_20_0,&t,&z2_10_0);
+
+  /* 2^40 - 2^20 */ fe4_square(&t,&z2_20_0); for (i = 1;i < 20;i++) { fe4_square(&t,&t); }
+  /* 2^40 - 2^0 */ fe4_mul(&t,&t,&z2_20_0);
+
+  /* 2^50 - 2^10 */ for (i = 0;i < 10;i++) { fe4_square(&t,&t); }
+  /* 2^50 - 2^0 */ fe4_mul(&z2_50_0,&t,&z2_10_0);
+
+  /* 2^100 - 2^50 */ fe4_square(&t,&z2_50_0); for (i = 1;i < 50;i++) { fe4_square(&t,&t); }
+  /* 2^100 - 2^0 */ fe4_mul(&z2_100_0,&t,&z2_50_0);
+
+  /* 2^200 - 2^100 */ fe4_square(&t,&z2_100_0); for (i = 1;i < 100;i++) { fe4_square(&t,&t); }
+  /* 2^200 - 2^0 */ fe4_mul(&t,&t,&z2_100_0);
+
+  /* 2^250 - 2^50 */ for (i = 0;i < 50;i++) { fe4_square(&t,&t); }
+  /* 2^250 - 2^0 */ fe4_mul(&t,&t,&z2_50_0);
+
+  /* 2^255 - 2^5 */ for (i = 0;i < 5;i++) { fe4_square(&t,&t); }
+  /* 2^255 - 21 */ fe4_mul(r,&t,&z11);
+}
+
+static void fe4_unpack(fe4 *r, const unsigned char x[32])
+{
+  int i,j;
+  for(i=0;i<4;i++)
+  {
+    r->v[i] = 0;
+    for(j=7;j>=0;j--)
+      r->v[i] = (r->v[i] << 8) | x[8*i+j];
+  }
+  r->v[3] &= 0x7fffffffffffffffULL;
+}
+
+static void fe4_pack(unsigned char r[32], const fe4 *x)
+{
+  crypto_uint128 c;
+  crypto_uint64 t[4], u[4], mask;
+  int i;
+
+  /* Fold bit 255, afterwards t < 2^255 + 19*2 */
+  c = (crypto_uint128)(x->v[3] >> 63) * 19;
+  t[3] = x->v[3] & 0x7fffffffffffffffULL;
+  for(i=0;i<3;i++)
+  {
+    c += x->v[i];
+    t[i] = (crypto_uint64)c;
+    c >>= 64;
+  }
+  t[3] += (crypto_uint64)c;
+
+  /* Subtract p if t >= p, i.e., if t + 19 >= 2^255 */
+  c = 19;
+  for(i=0;i<4;i++)
+  {
+    c += t[i];
+    u[i] = (crypto_uint64)c;
+    c >>= 64;
+  }
+  mask = -(u[3] >> 63);
+  u[3] &= 0x7fffffffffffffffULL;
+  for(i=0;i<4;i++)
+    t[i] ^= mask & (t[i] ^ u[i]);
+
+  for(i=0;i<32;i++)
+    r[i] = (t[i >> 3] >> (8*(i & 7))) & 0xff;
+}
+
+static void work_cswap(fe4 *work, unsigned char b)
+{
+  crypto_uint64 mask = b, t;
+  int i;
+  mask = -mask;
+  for(i=0;i<4;i++)
+  {
+    t = mask & (work[1].v[i] ^ work[3].v[i]);
+    work[1].v[i] ^= t;
+    work[3].v[i] ^= t;
+    t = mask & (work[2].v[i] ^ work[4].v[i]);
+    work[2].v[i] ^= t;
+    work[4].v[i] ^= t;
+  }
+}
+
+static void ladderstep(fe4 *work)
+{
+  fe4 t1,t2,t3,t4,t5,t6,t7;
+  fe4 *x0 = work;
+  fe4 *xp = work+1;
+  fe4 *zp = work+2;
+  fe4 *xq = work+3;
+  fe4 *zq = work+4;
+  fe4_add(&t1, xp, zp);
+  fe4_sub(&t2, xp, zp);
+  fe4_square(&t7, &t2);
+  fe4_square(&t6, &t1);
+  fe4_sub(&t5,&t6,&t7);
+  fe4_add(&t3, xq, zq);
+  fe4_sub(&t4, xq, zq);
+  fe4_mul(&t2,&t3,&t2);
+  fe4_mul(&t3,&t4,&t1);
+  fe4_add(xq, &t3, &t2);
+  fe4_sub(zq, &t3, &t2);
+  fe4_square(xq, xq);
+  fe4_square(zq, zq);
+  fe4_mul(zq, zq, x0);
+  fe4_mul(xp, &t6, &t7);
+  fe4_mul121666(zp, &t5);
+  fe4_add(zp, zp, &t7);
+  fe4_mul(zp, zp, &t5);
+}
+
+static void mladder(fe4 *xr, fe4 *zr, const unsigned char s[32])
+{
+  fe4 work[5];
+  unsigned char bit, prevbit=0;
+  unsigned char swap;
+  int i;
+
+  work[0] = *xr;
+  work[1].v[0] = 1; work[1].v[1] = work[1].v[2] = work[1].v[3] = 0;
+  work[2].v[0] = work[2].v[1] = work[2].v[2] = work[2].v[3] = 0;
+  work[3] = *xr;
+  work[4] = work[1];
+
+  for(i=254;i>=0;i--)
+  {
+    bit = 1&(s[i>>3]>>(i&7));
+    swap = bit ^ prevbit;
+    prevbit = bit;
+    work_cswap(work,swap);
+    ladderstep(work);
+  }
+  *xr = work[1];
+  *zr = work[2];
+}
+
+static void fe4_scalarmult_fe4(fe4 *x, fe4 *z, const unsigned char *s, const unsigned char *p)
+{
+  unsigned char e[32];
+  unsigned char i;
+
+  for(i=0;i<32;i++) e[i] = s[i];
+  e[0] &= 248;
+  e[31] &= 127;
+  e[31] |= 64;
+
+  fe4_unpack(x, p);
+  mladder(x, z, e);
+}
+
+static int fe4_scalarmult(
+    unsigned char *r,
+    const unsigned char *s,
+    const unsigned char *p
+    )
+{
+  fe4 t, z;
+
+  fe4_scalarmult_fe4(&t, &z, s, p);
+  fe4_invert(&z, &z);
+  fe4_mul(&t, &t, &z);
+  fe4_pack(r, &t);
+  return 0;
+}
+
+/* Same as fe4_scalarmult, but returns the projective result X, Z without
+ * the final inversion */
+static int fe4_scalarmult_xz(
+    unsigned char *x,
+    unsigned char *z,
+    const unsigned char *s,
+    const unsigned char *p
+    )
+{
+  fe4 t, w;
+
+  fe4_scalarmult_fe4(&t, &w, s, p);
+  fe4_pack(x, &t);
+  fe4_pack(z, &w);
+  return 0;
+}
+
+#endif
@@ -0,0 +1,309 @@
+/**
+ * This file is part of ECDH-Curve25519-Mobile.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+
+/*
+ * Curve25519 scalar multiplication for x86_64 CPUs with the BMI2 and ADX
+ * extensions. Field elements are kept in 4 saturated 64-bit words, i.e., as
+ * integers in [0,2^256) that are congruent to the represented value modulo
+ * 2^255-19. Multiplication uses MULX together with the two independent carry
+ * chains of ADCX and ADOX; reduction folds the upper half back using
+ * 2^256 = 38 mod 2^255-19. The ladder on top of these primitives is
+ * written in C (curve25519_fe4.h).
+ *
+ * This code must only be called if crypto_scalarmult_curve25519_mulx_supported()
+ * returns non-zero.
+ */
+
+#include "avrnacl.h"
+#include "curve25519_mulx.h"
+
+#if defined(CURVE25519_MULX)
+
+#include <cpuid.h>
+
+#include "curve25519_fe4.h"
+
+/* Reduce the 512-bit value in r8,...,r15 to 256 bits in r8,...,r11 */
+#define FE4_REDUCE \
+  "movl $38, %%edx\n\t" \
+  "xorl %%ebx, %%ebx\n\t" \
+  "mulxq %%r12, %%rax, %%r12\n\t" \
+  "adcxq %%rax, %%r8\n\t" \
+  "adoxq %%r12, %%r9\n\t" \
+  "mulxq %%r13, %%rax, %%r13\n\t" \
+  "adcxq %%rax, %%r9\n\t" \
+  "adoxq %%r13, %%r10\n\t" \
+  "mulxq %%r14, %%rax, %%r14\n\t" \
+  "adcxq %%rax, %%r10\n\t" \
+  "adoxq %%r14, %%r11\n\t" \
+  "mulxq %%r15, %%rax, %%r15\n\t" \
+  "adcxq %%rax, %%r11\n\t" \
+  "adoxq %%rbx, %%r15\n\t" \
+  "adcxq %%rbx, %%r15\n\t" \
+  "imulq $38, %%r15, %%r15\n\t" \
+  "addq %%r15, %%r8\n\t" \
+  "adcq %%rbx, %%r9\n\t" \
+  "adcq %%rbx, %%r10\n\t" \
+  "adcq %%rbx, %%r11\n\t" \
+  "sbbq %%rax, %%rax\n\t" \
+  "andq $38, %%rax\n\t" \
+  "addq %%rax, %%r8\n\t" \
+  "movq %%r8, 0(%[r])\n\t" \
+  "movq %%r9, 8(%[r])\n\t" \
+  "movq %%r10, 16(%[r])\n\t" \
+  "movq %%r11, 24(%[r])\n\t"
+
+/* Multiply a by the word b[i] and accumulate into lo,...,hi; hi is cleared
+ * first, which also clears CF and OF for the two carry chains */
+#define FE4_MULROW(i, t0, t1, t2, t3, hi) \
+  "movq " #i "(%[b]), %%rdx\n\t" \
+  "xorl %%" hi "d, %%" hi "d\n\t" \
+  "mulxq 0(%[a]), %%rax, %%rbx\n\t" \
+  "adoxq %%rax, %%" t0 "\n\t" \
+  "adcxq %%rbx, %%" t1 "\n\t" \
+  "mulxq 8(%[a]), %%rax, %%rbx\n\t" \
+  "adoxq %%rax, %%" t1 "\n\t" \
+  "adcxq %%rbx, %%" t2 "\n\t" \
+  "mulxq 16(%[a]), %%rax, %%rbx\n\t" \
+  "adoxq %%rax, %%" t2 "\n\t" \
+  "adcxq %%rbx, %%" t3 "\n\t" \
+  "mulxq 24(%[a]), %%rax, %%rbx\n\t" \
+  "adoxq %%rax, %%" t3 "\n\t" \
+  "adcxq %%rbx, %%" hi "\n\t" \
+  "movq $0, %%rax\n\t" \
+  "adoxq %%rax, %%" hi "\n\t"
+
+static void fe4_mul(fe4 *r, const fe4 *a, const fe4 *b)
+{
+  __asm__ __volatile__(
+    "movq 0(%[b]), %%rdx\n\t"
+    "mulxq 0(%[a]), %%r8, %%r9\n\t"
+    "mulxq 8(%[a]), %%rax, %%r10\n\t"
+    "addq %%rax, %%r9\n\t"
+    "mulxq 16(%[a]), %%rax, %%r11\n\t"
+    "adcq %%rax, %%r10\n\t"
+    "mulxq 24(%[a]), %%rax, %%r12\n\t"
+    "adcq %%rax, %%r11\n\t"
+    "adcq $0, %%r12\n\t"
+    FE4_MULROW(8, "r9", "r10", "r11", "r12", "r13")
+    FE4_MULROW(16, "r10", "r11", "r12", "r13", "r14")
+    FE4_MULROW(24, "r11", "r12", "r13", "r14", "r15")
+    FE4_REDUCE
+    :
+    : [r] "r" (r->v), [a] "r" (a->v), [b] "r" (b->v)
+    : "rax", "rbx", "rdx", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15", "cc", "memory"
+  );
+}
+
+static void fe4_square(fe4 *r, const fe4 *a)
+{
+  __asm__ __volatile__(
+    /* Products a[i]*a[j] with i < j */
+    "movq 0(%[a]), %%rdx\n\t"
+    "mulxq 8(%[a]), %%r9, %%r10\n\t"
+    "mulxq 16(%[a]), %%rax, %%r11\n\t"
+    "addq %%rax, %%r10\n\t"
+    "mulxq 24(%[a]), %%rax, %%r12\n\t"
+    "adcq %%rax, %%r11\n\t"
+    "adcq $0, %%r12\n\t"
+    "movq 8(%[a]), %%rdx\n\t"
+    "xorl %%r13d, %%r13d\n\t"
+    "mulxq 16(%[a]), %%rax, %%rbx\n\t"
+    "adoxq %%rax, %%r11\n\t"
+    "adcxq %%rbx, %%r12\n\t"
+    "mulxq 24(%[a]), %%rax, %%rbx\n\t"
+    "adoxq %%rax, %%r12\n\t"
+    "adcxq %%rbx, %%r13\n\t"
+    "movq $0, %%rax\n\t"
+    "adoxq %%rax, %%r13\n\t"
+    "movq 16(%[a]), %%rdx\n\t"
+    "mulxq 24(%[a]), %%rax, %%r14\n\t"
+    "addq %%rax, %%r13\n\t"
+    "adcq $0, %%r14\n\t"
+    /* Double them */
+    "xorl %%r15d, %%r15d\n\t"
+    "addq %%r9, %%r9\n\t"
+    "adcq %%r10, %%r10\n\t"
+    "adcq %%r11, %%r11\n\t"
+    "adcq %%r12, %%r12\n\t"
+    "adcq %%r13, %%r13\n\t"
+    "adcq %%r14, %%r14\n\t"
+    "adcq %%r15, %%r15\n\t"
+    /* Add the squares a[i]*a[i] */
+    "movq 0(%[a]), %%rdx\n\t"
+    "mulxq %%rdx, %%r8, %%rax\n\t"
+    "addq %%rax, %%r9\n\t"
+    "movq 8(%[a]), %%rdx\n\t"
+    "mulxq %%rdx, %%rax, %%rbx\n\t"
+    "adcq %%rax, %%r10\n\t"
+    "adcq %%rbx, %%r11\n\t"
+    "movq 16(%[a]), %%rdx\n\t"
+    "mulxq %%rdx, %%rax, %%rbx\n\t"
+    "adcq %%rax, %%r12\n\t"
+    "adcq %%rbx, %%r13\n\t"
+    "movq 24(%[a]), %%rdx\n\t"
+    "mulxq %%rdx, %%rax, %%rbx\n\t"
+    "adcq %%rax, %%r14\n\t"
+    "adcq %%rbx, %%r15\n\t"
+    FE4_REDUCE
+    :
+    : [r] "r" (r->v), [a] "r" (a->v)
+    : "rax", "rbx", "rdx", "r8", "r9", "r10", "r11", "r12", "r13", "r14", "r15", "cc", "memory"
+  );
+}
+
+static void fe4_mul121666(fe4 *r, const fe4 *a)
+{
+  __asm__ __volatile__(
+    "movl $121666, %%edx\n\t"
+    "mulxq 0(%[a]), %%r8, %%r9\n\t"
+    "mulxq 8(%[a]), %%rax, %%r10\n\t"
+    "addq %%rax, %%r9\n\t"
+    "mulxq 16(%[a]), %%rax, %%r11\n\t"
+    "adcq %%rax, %%r10\n\t"
+    "mulxq 24(%[a]), %%rax, %%rdx\n\t"
+    "adcq %%rax, %%r11\n\t"
+    "adcq $0, %%rdx\n\t"
+    "imulq $38, %%rdx, %%rdx\n\t"
+    "addq %%rdx, %%r8\n\t"
+    "adcq $0, %%r9\n\t"
+    "adcq $0, %%r10\n\t"
+    "adcq $0, %%r11\n\t"
+    "sbbq %%rax, %%rax\n\t"
+    "andq $38, %%rax\n\t"
+    "addq %%rax, %%r8\n\t"
+    "movq %%r8, 0(%[r])\n\t"
+    "movq %%r9, 8(%[r])\n\t"
+    "movq %%r10, 16(%[r])\n\t"
+    "movq %%r11, 24(%[r])\n\t"
+    :
+    : [r] "r" (r->v), [a] "r" (a->v)
+    : "rax", "rdx", "r8", "r9", "r10", "r11", "cc", "memory"
+  );
+}
+
+static void fe4_add(fe4 *r, const fe4 *a, const fe4 *b)
+{
+  __asm__ __volatile__(
+    "movq 0(%[a]), %%r8\n\t"
+    "movq 8(%[a]), %%r9\n\t"
+    "movq 16(%[a]), %%r10\n\t"
+    "movq 24(%[a]), %%r11\n\t"
+    "addq 0(%[b]), %%r8\n\t"
+    "adcq 8(%[b]), %%r9\n\t"
+    "adcq 16(%[b]), %%r10\n\t"
+    "adcq 24(%[b]), %%r11\n\t"
+    "sbbq %%rax, %%rax\n\t"
+    "andq $38, %%rax\n\t"
+    "addq %%rax, %%r8\n\t"
+    "adcq $0, %%r9\n\t"
+    "adcq $0, %%r10\n\t"
+    "adcq $0, %%r11\n\t"
+    "sbbq %%rax, %%rax\n\t"
+    "andq $38, %%rax\n\t"
+    "addq %%rax, %%r8\n\t"
+    "movq %%r8, 0(%[r])\n\t"
+    "movq %%r9, 8(%[r])\n\t"
+    "movq %%r10, 16(%[r])\n\t"
+    "movq %%r11, 24(%[r])\n\t"
+    :
+    : [r] "r" (r->v), [a] "r" (a->v), [b] "r" (b->v)
+    : "rax", "r8", "r9", "r10", "r11", "cc", "memory"
+  );
+}
+
+static void fe4_sub(fe4 *r, const fe4 *a, const fe4 *b)
+{
+  __asm__ __volatile__(
+    "movq 0(%[a]), %%r8\n\t"
+    "movq 8(%[a]), %%r9\n\t"
+    "movq 16(%[a]), %%r10\n\t"
+    "movq 24(%[a]), %%r11\n\t"
+    "subq 0(%[b]), %%r8\n\t"
+    "sbbq 8(%[b]), %%r9\n\t"
+    "sbbq 16(%[b]), %%r10\n\t"
+    "sbbq 24(%[b]), %%r11\n\t"
+    "sbbq %%rax, %%rax\n\t"
+    "andq $38, %%rax\n\t"
+    "subq %%rax, %%r8\n\t"
+    "sbbq $0, %%r9\n\t"
+    "sbbq $0, %%r10\n\t"
+    "sbbq $0, %%r11\n\t"
+    "sbbq %%rax, %%rax\n\t"
+    "andq $38, %%rax\n\t"
+    "subq %%rax, %%r8\n\t"
+    "movq %%r8, 0(%[r])\n\t"
+    "movq %%r9, 8(%[r])\n\t"
+    "movq %%r10, 16(%[r])\n\t"
+    "movq %%r11, 24(%[r])\n\t"
+    :
+    : [r] "r" (r->v), [a] "r" (a->v), [b] "r" (b->v)
+    : "rax", "r8", "r9", "r10", "r11", "cc", "memory"
+  );
+}
+
+int crypto_scalarmult_curve25519_mulx_supported(void)
+{
+  /* Checked once; concurrent first calls store the same value */
+  static int supported = -1;
+  unsigned int eax, ebx, ecx, edx;
+  int r = __atomic_load_n(&supported, __ATOMIC_RELAXED);
+
+  if(r < 0)
+  {
+    /* CPUID leaf 7: EBX bit 8 is BMI2 (MULX), bit 19 is ADX */
+    if(__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+      r = ((ebx >> 8) & 1) && ((ebx >> 19) & 1);
+    else
+      r = 0;
+    __atomic_store_n(&supported, r, __ATOMIC_RELAXED);
+  }
+  return r;
+}
+
+int crypto_scalarmult_curve25519_mulx(
+    unsigned char *r,
+    const unsigned char *s,
+    const unsigned char *p
+    )
+{
+  return fe4_scalarmult(r,s,p);
+}
+
+int crypto_scalarmult_curve25519_mulx_xz(
+    unsigned char *x,
+    unsigned char *z,
+    const unsigned char *s,
+    const unsigned char *p
+    )
+{
+  return fe4_scalarmult_xz(x,z,s,p);
+}
+
+#endif
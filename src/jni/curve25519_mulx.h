@@ -0,0 +1,18 @@
+#ifndef CURVE25519_MULX_H
+#define CURVE25519_MULX_H
+
+/* Curve25519 for x86_64 CPUs supporting the BMI2 and ADX extensions
+ * (curve25519_mulx.c). The code uses GNU inline assembly. */
+
+#if defined(__x86_64__) && defined(__GNUC__)
+  #define CURVE25519_MULX
+#endif
+
+int crypto_scalarmult_curve25519_mulx_supported(void);
+
+int crypto_scalarmult_curve25519_mulx(unsigned char *r, const unsigned char *s, const unsigned char *p);
+
+/* The projective result X, Z of the ladder, without the final inversion */
+int crypto_scalarmult_curve25519_mulx_xz(unsigned char *x, unsigned char *z, const unsigned char *s, const unsigned char *p);
+
+#endif
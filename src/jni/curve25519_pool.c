@@ -0,0 +1,229 @@
+/**
+ * This file is part of ECDH-Curve25519-Mobile.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+
+/*
+ * Worker pool for batch scalar multiplication. A batch is cut into chunks
+ * of at most CHUNK inputs; every thread, the caller included, repeatedly
+ * claims the next chunk with an atomic add on a shared index and runs
+ * crypto_scalarmult_curve25519_batch on it, so threads that are faster or
+ * start earlier simply take more chunks. CHUNK is the number of inputs
+ * that crypto_scalarmult_curve25519_batch normalizes with one inversion;
+ * for small batches the chunks are made smaller (but still a multiple of 4
+ * for the 4-way AVX2 ladder) so that all threads get work.
+ *
+ * The workers sleep on a condition variable between batches. A batch is
+ * published under the lock together with a new generation number; the
+ * submitter returns when all inputs are done and no worker touches the
+ * batch any more.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "avrnacl.h"
+#include "curve25519_dispatch.h"
+#include "curve25519_pool.h"
+
+#define CHUNK 32
+
+struct crypto_scalarmult_curve25519_pool
+{
+  pthread_mutex_t submit;       /* held by the submitter of the running batch */
+  pthread_mutex_t lock;         /* protects everything below */
+  pthread_cond_t work;          /* a batch was published, or shutdown */
+  pthread_cond_t done;          /* a worker left the batch */
+  pthread_t *workers;
+  unsigned int nworkers;
+  unsigned int active;          /* workers working on the batch */
+  unsigned long generation;
+  int shutdown;
+
+  /* The batch; written only under lock while active == 0 */
+  unsigned char (*r)[32];
+  const unsigned char (*s)[32];
+  const unsigned char (*p)[32];
+  unsigned long long n;
+  unsigned long long chunk;
+  unsigned long long next;      /* first unclaimed input (atomic) */
+  unsigned long long remaining; /* inputs not yet finished (atomic) */
+};
+
+static void run_chunks(crypto_scalarmult_curve25519_pool *pool)
+{
+  unsigned long long i, m;
+
+  for(;;)
+  {
+    i = __atomic_fetch_add(&pool->next, pool->chunk, __ATOMIC_RELAXED);
+    if(i >= pool->n)
+      break;
+    m = (pool->n - i < pool->chunk) ? pool->n - i : pool->chunk;
+    crypto_scalarmult_curve25519_batch(pool->r+i, pool->s+i, pool->p+i, m);
+    __atomic_fetch_sub(&pool->remaining, m, __ATOMIC_RELEASE);
+  }
+}
+
+static void *worker(void *arg)
+{
+  crypto_scalarmult_curve25519_pool *pool = arg;
+  unsigned long seen = 0;
+
+  pthread_mutex_lock(&pool->lock);
+  for(;;)
+  {
+    while(!pool->shutdown && pool->generation == seen)
+      pthread_cond_wait(&pool->work, &pool->lock);
+    if(pool->shutdown)
+      break;
+    seen = pool->generation;
+    pool->active++;
+    pthread_mutex_unlock(&pool->lock);
+
+    run_chunks(pool);
+
+    pthread_mutex_lock(&pool->lock);
+    pool->active--;
+    if(pool->active == 0)
+      pthread_cond_broadcast(&pool->done);
+  }
+  pthread_mutex_unlock(&pool->lock);
+  return NULL;
+}
+
+crypto_scalarmult_curve25519_pool *crypto_scalarmult_curve25519_pool_create(unsigned int threads)
+{
+  crypto_scalarmult_curve25519_pool *pool;
+  unsigned int i;
+
+  if(threads == 0)
+  {
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    threads = (ncpu > 0) ? (unsigned int)ncpu : 1;
+  }
+
+  pool = calloc(1, sizeof(*pool));
+  if(pool == NULL)
+    return NULL;
+  pool->workers = calloc(threads, sizeof(pthread_t));
+  if(pool->workers == NULL)
+  {
+    free(pool);
+    return NULL;
+  }
+  pthread_mutex_init(&pool->submit, NULL);
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->work, NULL);
+  pthread_cond_init(&pool->done, NULL);
+
+  /* The calling thread is one of the threads */
+  for(i=0;i+1<threads;i++)
+  {
+    if(pthread_create(&pool->workers[i], NULL, worker, pool) != 0)
+    {
+      crypto_scalarmult_curve25519_pool_destroy(pool);
+      return NULL;
+    }
+    pool->nworkers++;
+  }
+  return pool;
+}
+
+void crypto_scalarmult_curve25519_pool_destroy(crypto_scalarmult_curve25519_pool *pool)
+{
+  unsigned int i;
+
+  if(pool == NULL)
+    return;
+  pthread_mutex_lock(&pool->lock);
+  pool->shutdown = 1;
+  pthread_cond_broadcast(&pool->work);
+  pthread_mutex_unlock(&pool->lock);
+  for(i=0;i<pool->nworkers;i++)
+    pthread_join(pool->workers[i], NULL);
+
+  pthread_cond_destroy(&pool->done);
+  pthread_cond_destroy(&pool->work);
+  pthread_mutex_destroy(&pool->lock);
+  pthread_mutex_destroy(&pool->submit);
+  free(pool->workers);
+  free(pool);
+}
+
+unsigned int crypto_scalarmult_curve25519_pool_threads(const crypto_scalarmult_curve25519_pool *pool)
+{
+  return pool->nworkers + 1;
+}
+
+int crypto_scalarmult_curve25519_pool_batch(
+    crypto_scalarmult_curve25519_pool *pool,
+    unsigned char r[][32],
+    const unsigned char s[][32],
+    const unsigned char p[][32],
+    unsigned long long n
+    )
+{
+  unsigned long long chunk;
+  unsigned int threads = pool->nworkers + 1;
+
+  /* Not worth waking the workers for a single chunk */
+  if(pool->nworkers == 0 || n <= 4)
+    return crypto_scalarmult_curve25519_batch(r, s, p, n);
+
+  /* At least two chunks per thread, if the batch is large enough */
+  chunk = (n + 2*threads - 1) / (2*threads);
+  chunk = (chunk + 3) & ~3ULL;
+  if(chunk > CHUNK)
+    chunk = CHUNK;
+
+  pthread_mutex_lock(&pool->submit);
+  pthread_mutex_lock(&pool->lock);
+  /* Workers that woke up late for the previous batch may still look at it */
+  while(pool->active > 0)
+    pthread_cond_wait(&pool->done, &pool->lock);
+  pool->r = r;
+  pool->s = s;
+  pool->p = p;
+  pool->n = n;
+  pool->chunk = chunk;
+  pool->next = 0;
+  pool->remaining = n;
+  pool->generation++;
+  pthread_cond_broadcast(&pool->work);
+  pthread_mutex_unlock(&pool->lock);
+
+  run_chunks(pool);
+
+  pthread_mutex_lock(&pool->lock);
+  while(pool->active > 0 || __atomic_load_n(&pool->remaining, __ATOMIC_ACQUIRE) > 0)
+    pthread_cond_wait(&pool->done, &pool->lock);
+  pthread_mutex_unlock(&pool->lock);
+  pthread_mutex_unlock(&pool->submit);
+  return 0;
+}
@@ -0,0 +1,26 @@
+#ifndef CURVE25519_POOL_H
+#define CURVE25519_POOL_H
+
+/* A fixed set of worker threads for crypto_scalarmult_curve25519_batch
+ * (curve25519_pool.c). A batch is split into chunks that the workers and
+ * the calling thread take from a shared counter until none are left. The
+ * threads are created once and reused for every batch. */
+
+typedef struct crypto_scalarmult_curve25519_pool crypto_scalarmult_curve25519_pool;
+
+/* Pool in which batches run on the given number of threads, including the
+ * calling one; 0 means one per online CPU. Returns NULL if the threads
+ * cannot be created. */
+crypto_scalarmult_curve25519_pool *crypto_scalarmult_curve25519_pool_create(unsigned int threads);
+
+/* Stops and joins the workers. No batch may be running. */
+void crypto_scalarmult_curve25519_pool_destroy(crypto_scalarmult_curve25519_pool *pool);
+
+/* Number of threads a batch runs on */
+unsigned int crypto_scalarmult_curve25519_pool_threads(const crypto_scalarmult_curve25519_pool *pool);
+
+/* Same result as crypto_scalarmult_curve25519_batch, computed by the threads
+ * of the pool. Batches submitted concurrently run one after the other. */
+int crypto_scalarmult_curve25519_pool_batch(crypto_scalarmult_curve25519_pool *pool, unsigned char r[][32], const unsigned char s[][32], const unsigned char p[][32], unsigned long long n);
+
+#endif
@@ -0,0 +1,97 @@
+/**
+ * This file is part of ECDH-Curve25519-Mobile.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+
+/*
+ * The Montgomery point u corresponds to the Edwards points with
+ * y = (u-1)/(u+1). Scalar multiplication commutes with this map, and
+ * s*P and s*(-P) have the same u, so the sign of x does not matter. Points
+ * that have no Edwards counterpart (u = -1, and points on the twist where
+ * x is not in the field) fall back to the Montgomery ladder.
+ */
+
+#include "avrnacl.h"
+#include "fe25519.h"
+#include "ge25519.h"
+#include "curve25519_precomp.h"
+
+/* Checks at compile time that the context contains no padding */
+typedef char precomp_ctx_size_check[(sizeof(crypto_scalarmult_curve25519_precomp_ctx) == crypto_scalarmult_curve25519_PRECOMPBYTES) ? 1 : -1];
+
+int crypto_scalarmult_curve25519_precompute(
+    crypto_scalarmult_curve25519_precomp_ctx *ctx,
+    const unsigned char *p
+    )
+{
+  unsigned char yb[32];
+  fe25519 u, n, d;
+  ge25519_p3 q;
+  int i;
+
+  for(i=0;i<32;i++) ctx->p[i] = p[i];
+  ctx->use_table = 0;
+
+  fe25519_unpack(&u, p);
+  fe25519_setone(&d);
+  fe25519_sub(&n, &u, &d);
+  fe25519_add(&d, &u, &d);
+  if(fe25519_iszero(&d))
+    return 0;
+  fe25519_invert(&d, &d);
+  fe25519_mul(&n, &n, &d);
+  fe25519_pack(yb, &n);
+  if(ge25519_frombytes_vartime(&q, yb) != 0)
+    return 0;
+
+  ge25519_table_build(&ctx->table, &q);
+  ctx->use_table = 1;
+  return 0;
+}
+
+int crypto_scalarmult_curve25519_precomp(
+    unsigned char *r,
+    const unsigned char *s,
+    const crypto_scalarmult_curve25519_precomp_ctx *ctx
+    )
+{
+  unsigned char e[32];
+  unsigned char i;
+  ge25519_p3 q;
+
+  if(!ctx->use_table)
+    return crypto_scalarmult_curve25519(r, s, ctx->p);
+
+  for(i=0;i<32;i++) e[i] = s[i];
+  e[0] &= 248;
+  e[31] &= 127;
+  e[31] |= 64;
+
+  ge25519_scalarmult_table(&q, &ctx->table, e);
+  ge25519_pack_montgomery(r, &q);
+  return 0;
+}
@@ -0,0 +1,29 @@
+#ifndef CURVE25519_PRECOMP_H
+#define CURVE25519_PRECOMP_H
+
+/* Scalar multiplication of a point that is used many times
+ * (curve25519_precomp.c). The point is converted once to the equivalent
+ * Edwards curve and a table of its multiples is stored, after which each
+ * scalar multiplication costs about as much as a fixed-base one. */
+
+#include "ge25519.h"
+
+/* Only bytes, so the size is the same on every target */
+typedef struct
+{
+  ge25519_table table;
+  unsigned char p[32];
+  unsigned char use_table;
+}
+crypto_scalarmult_curve25519_precomp_ctx;
+
+#define crypto_scalarmult_curve25519_PRECOMPBYTES (32*8*96 + 32 + 1)
+
+/* Prepare ctx for multiplications of p. Takes time depending on p, which
+ * is assumed to be public. */
+int crypto_scalarmult_curve25519_precompute(crypto_scalarmult_curve25519_precomp_ctx *ctx, const unsigned char *p);
+
+/* r = s*p for the point p of ctx; same result as crypto_scalarmult_curve25519 */
+int crypto_scalarmult_curve25519_precomp(unsigned char *r, const unsigned char *s, const crypto_scalarmult_curve25519_precomp_ctx *ctx);
+
+#endif
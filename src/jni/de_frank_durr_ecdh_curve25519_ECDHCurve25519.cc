@@ -29,80 +29,400 @@
  * For more information, please refer to <http://unlicense.org/>
  */
 
-#include "de_frank_durr_ecdh_curve25519_ECDHCurve25519.h"
+// The native methods of class de.frank_durr.ecdh_curve25519.ECDHCurve25519.
+// They are registered in JNI_OnLoad with RegisterNatives instead of being
+// looked up by their mangled names.
+//
+// Byte arrays are accessed with GetPrimitiveArrayCritical, which on most VMs
+// pins the array instead of copying it. The critical section spans one
+// scalar multiplication (tens of microseconds) and contains no JNI calls.
+// The array lengths and offsets are checked here, so the Java wrappers call
+// straight into native code. A violation throws
+// java.security.InvalidParameterException.
+
+#include <jni.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
 #include "ecdh_curve25519.h"
 
-JNIEXPORT jbyteArray JNICALL Java_de_frank_1durr_ecdh_1curve25519_ECDHCurve25519_secret_1key
-  (JNIEnv *env, jclass ecdhcurve25519_jclass, jbyteArray random_number_jobj)
-{
-     // We assume that the array random_number_jobj has length
-     // ECDH_CURVE25519_KEY_LENGTH. This should be checked on the Java side
-     // before calling this native function.
-     uint8_t random_number[ECDH_CURVE25519_KEY_LENGTH];
-     // jbyte is actually a signed char. So we can safely typecast (uint8_t *) 
-     // to (jbyte *).
-     env->GetByteArrayRegion(random_number_jobj, 0, ECDH_CURVE25519_KEY_LENGTH,
-			     (jbyte *) random_number);
-     
-     uint8_t secret_key[ECDH_CURVE25519_KEY_LENGTH];
-     ecdh_curve25519_secret_key(secret_key, random_number);
-
-     jbyteArray secret_key_jobj = env->NewByteArray(ECDH_CURVE25519_KEY_LENGTH);
-     env->SetByteArrayRegion(secret_key_jobj, 0, ECDH_CURVE25519_KEY_LENGTH, 
-			     (jbyte *) secret_key);
-     
-     return secret_key_jobj;
-}
-
-JNIEXPORT jbyteArray JNICALL Java_de_frank_1durr_ecdh_1curve25519_ECDHCurve25519_public_1key
-  (JNIEnv *env, jclass ecdhcurve25519_jclass, jbyteArray secret_key_jobj)
-{
-     // We assume that the array secret_key_jobj has length
-     // ECDH_CURVE25519_KEY_LENGTH. This should be checked on the Java side
-     // before calling this native function.
-     uint8_t secret_key[ECDH_CURVE25519_KEY_LENGTH];
-     // jbyte is actually a signed char. So we can safely typecast (uint8_t *)
-     // to (jbyte *).
-     env->GetByteArrayRegion(secret_key_jobj, 0, ECDH_CURVE25519_KEY_LENGTH,
-			     (jbyte *) secret_key);
-     
-     uint8_t public_key[ECDH_CURVE25519_KEY_LENGTH];
-     ecdh_curve25519_public_key(public_key, secret_key);
-
-     jbyteArray public_key_jobj = env->NewByteArray(ECDH_CURVE25519_KEY_LENGTH);
-     env->SetByteArrayRegion(public_key_jobj, 0, ECDH_CURVE25519_KEY_LENGTH, 
-			     (jbyte *) public_key);
-     
-     return public_key_jobj;
-}
-
-JNIEXPORT jbyteArray JNICALL Java_de_frank_1durr_ecdh_1curve25519_ECDHCurve25519_shared_1secret
-  (JNIEnv *env, jclass ecdhcurve25519_jclass, jbyteArray my_secret_key_jobj, 
-   jbyteArray others_public_key_jobj)
-{
-     // We assume that the arrays my_secret_key_jobj and 
-     // others_public_key_jobj have length ECDH_CURVE25519_KEY_LENGTH. 
-     // This should be checked on the Java side before calling this native 
-     // function.
-     uint8_t my_secret_key[ECDH_CURVE25519_KEY_LENGTH];
-     uint8_t others_public_key[ECDH_CURVE25519_KEY_LENGTH];
-     // jbyte is actually a signed char. So we can safely typecast (uint8_t *) 
-     // to (jbyte *).
+#define CLASS_NAME "de/frank_durr/ecdh_curve25519/ECDHCurve25519"
+
+// Records per chunk of the batch functions
+#define BATCH_CHUNK 32
+
+// Global reference to java.security.InvalidParameterException
+static jclass invalid_parameter_exception = NULL;
+
+// Native worker threads of shared_secrets_parallel, created on first use
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static ecdh_curve25519_pool *pool = NULL;
+
+// Check that array_jobj has ECDH_CURVE25519_KEY_LENGTH bytes at offset off;
+// if not, throw an InvalidParameterException and return false.
+static bool check_range(JNIEnv *env, jbyteArray array_jobj, jint off)
+{
+     if (array_jobj == NULL || off < 0 ||
+	 off > env->GetArrayLength(array_jobj) - ECDH_CURVE25519_KEY_LENGTH) {
+	  env->ThrowNew(invalid_parameter_exception,
+			"Array must have 32 bytes at the given offset");
+	  return false;
+     }
+     return true;
+}
+
+// Address of the key at offset off in the direct buffer buffer_jobj, or NULL
+// (with an InvalidParameterException pending) if buffer_jobj is not a direct
+// buffer or too short.
+static uint8_t *direct_key(JNIEnv *env, jobject buffer_jobj, jint off)
+{
+     uint8_t *buffer = (uint8_t *) env->GetDirectBufferAddress(buffer_jobj);
+     jlong capacity = env->GetDirectBufferCapacity(buffer_jobj);
+     if (buffer == NULL || off < 0 ||
+	 capacity < (jlong) off + ECDH_CURVE25519_KEY_LENGTH) {
+	  env->ThrowNew(invalid_parameter_exception, "Invalid direct buffer");
+	  return NULL;
+     }
+     return buffer + off;
+}
+
+// Operation on up to two input keys with one 32-byte result
+typedef void (*key_op)(uint8_t result[ECDH_CURVE25519_KEY_LENGTH],
+		       const uint8_t *in1, const uint8_t *in2);
+
+static void op_secret_key(uint8_t result[ECDH_CURVE25519_KEY_LENGTH],
+			  const uint8_t *random_number, const uint8_t *unused)
+{
+     ecdh_curve25519_secret_key(result, random_number);
+}
+
+static void op_public_key(uint8_t result[ECDH_CURVE25519_KEY_LENGTH],
+			  const uint8_t *secret_key, const uint8_t *unused)
+{
+     ecdh_curve25519_public_key(result, secret_key);
+}
+
+static void op_shared_secret(uint8_t result[ECDH_CURVE25519_KEY_LENGTH],
+			     const uint8_t *my_secret_key,
+			     const uint8_t *others_public_key)
+{
+     ecdh_curve25519_shared_secret(result, my_secret_key, others_public_key);
+}
+
+// Run op on the keys at the given offsets of the byte arrays in1_jobj and
+// in2_jobj (NULL if op only takes one key) and write the result to out_jobj
+// at offset out_off. The arrays may be the same.
+static void run_on_arrays(JNIEnv *env, key_op op, jbyteArray in1_jobj,
+			  jint in1_off, jbyteArray in2_jobj, jint in2_off,
+			  jbyteArray out_jobj, jint out_off)
+{
+     if (!check_range(env, in1_jobj, in1_off) ||
+	 (in2_jobj != NULL && !check_range(env, in2_jobj, in2_off)) ||
+	 !check_range(env, out_jobj, out_off))
+	  return;
+
+     uint8_t result[ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t *in1 = NULL, *in2 = NULL, *out = NULL;
+     in1 = (uint8_t *) env->GetPrimitiveArrayCritical(in1_jobj, NULL);
+     if (in1 == NULL)
+	  return;
+     if (in2_jobj != NULL) {
+	  in2 = (uint8_t *) env->GetPrimitiveArrayCritical(in2_jobj, NULL);
+	  if (in2 == NULL)
+	       goto release;
+     }
+     out = (uint8_t *) env->GetPrimitiveArrayCritical(out_jobj, NULL);
+     if (out == NULL)
+	  goto release;
+
+     // The result goes to the stack first since out may overlap an input.
+     op(result, in1 + in1_off, in2 != NULL ? in2 + in2_off : NULL);
+     memcpy(out + out_off, result, ECDH_CURVE25519_KEY_LENGTH);
+     memset(result, 0, sizeof(result));
+
+     env->ReleasePrimitiveArrayCritical(out_jobj, out, 0);
+release:
+     if (in2 != NULL)
+	  env->ReleasePrimitiveArrayCritical(in2_jobj, in2, JNI_ABORT);
+     env->ReleasePrimitiveArrayCritical(in1_jobj, in1, JNI_ABORT);
+}
+
+static void JNICALL secret_key_into(JNIEnv *env, jclass ecdhcurve25519_jclass,
+				    jbyteArray random_number_jobj,
+				    jint random_number_off,
+				    jbyteArray out_jobj, jint out_off)
+{
+     run_on_arrays(env, op_secret_key, random_number_jobj, random_number_off,
+		   NULL, 0, out_jobj, out_off);
+}
+
+static void JNICALL public_key_into(JNIEnv *env, jclass ecdhcurve25519_jclass,
+				    jbyteArray secret_key_jobj,
+				    jint secret_key_off,
+				    jbyteArray out_jobj, jint out_off)
+{
+     run_on_arrays(env, op_public_key, secret_key_jobj, secret_key_off,
+		   NULL, 0, out_jobj, out_off);
+}
+
+static void JNICALL shared_secret_into(JNIEnv *env,
+				       jclass ecdhcurve25519_jclass,
+				       jbyteArray my_secret_key_jobj,
+				       jint my_secret_key_off,
+				       jbyteArray others_public_key_jobj,
+				       jint others_public_key_off,
+				       jbyteArray out_jobj, jint out_off)
+{
+     run_on_arrays(env, op_shared_secret, my_secret_key_jobj,
+		   my_secret_key_off, others_public_key_jobj,
+		   others_public_key_off, out_jobj, out_off);
+}
+
+static void JNICALL public_key_direct(JNIEnv *env,
+				      jclass ecdhcurve25519_jclass,
+				      jobject secret_key_jobj,
+				      jint secret_key_off,
+				      jobject public_key_jobj,
+				      jint public_key_off)
+{
+     // The keys are accessed in place; no copies of the Java objects.
+     const uint8_t *secret_key = direct_key(env, secret_key_jobj,
+					    secret_key_off);
+     if (secret_key == NULL)
+	  return;
+     uint8_t *public_key = direct_key(env, public_key_jobj, public_key_off);
+     if (public_key == NULL)
+	  return;
+
+     // The output may overlap the input, so it is calculated on the stack
+     // first.
+     uint8_t result[ECDH_CURVE25519_KEY_LENGTH];
+     ecdh_curve25519_public_key(result, secret_key);
+     memcpy(public_key, result, ECDH_CURVE25519_KEY_LENGTH);
+}
+
+static void JNICALL shared_secret_direct(JNIEnv *env,
+					 jclass ecdhcurve25519_jclass,
+					 jobject my_secret_key_jobj,
+					 jint my_secret_key_off,
+					 jobject others_public_key_jobj,
+					 jint others_public_key_off,
+					 jobject shared_secret_jobj,
+					 jint shared_secret_off)
+{
+     const uint8_t *my_secret_key = direct_key(env, my_secret_key_jobj,
+					       my_secret_key_off);
+     if (my_secret_key == NULL)
+	  return;
+     const uint8_t *others_public_key = direct_key(env, others_public_key_jobj,
+						   others_public_key_off);
+     if (others_public_key == NULL)
+	  return;
+     uint8_t *shared_secret = direct_key(env, shared_secret_jobj,
+					 shared_secret_off);
+     if (shared_secret == NULL)
+	  return;
+
+     uint8_t result[ECDH_CURVE25519_KEY_LENGTH];
+     ecdh_curve25519_shared_secret(result, my_secret_key, others_public_key);
+     memcpy(shared_secret, result, ECDH_CURVE25519_KEY_LENGTH);
+}
+
+// Check that the flat arrays hold count keys (or one key if single is true
+// for in1_jobj); if not, throw an InvalidParameterException and return false.
+static bool check_flat(JNIEnv *env, jbyteArray in1_jobj, bool single,
+		       jbyteArray in2_jobj, jbyteArray out_jobj, jint count)
+{
+     jlong len = (jlong) count*ECDH_CURVE25519_KEY_LENGTH;
+     if (count < 0 || in1_jobj == NULL || out_jobj == NULL ||
+	 env->GetArrayLength(in1_jobj) <
+	 (single ? ECDH_CURVE25519_KEY_LENGTH : len) ||
+	 (in2_jobj != NULL && env->GetArrayLength(in2_jobj) < len) ||
+	 env->GetArrayLength(out_jobj) < len) {
+	  env->ThrowNew(invalid_parameter_exception,
+			"Arrays must hold count keys of 32 bytes");
+	  return false;
+     }
+     return true;
+}
+
+// The batch functions copy chunks of BATCH_CHUNK records instead of pinning
+// the arrays: a batch can run for a long time, and a critical section would
+// block the garbage collector for all of it.
+
+static void JNICALL public_keys(JNIEnv *env, jclass ecdhcurve25519_jclass,
+				jbyteArray secret_keys_jobj,
+				jbyteArray out_jobj, jint count)
+{
+     if (!check_flat(env, secret_keys_jobj, false, NULL, out_jobj, count))
+	  return;
+
+     uint8_t secret_key[BATCH_CHUNK][ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t public_key[BATCH_CHUNK][ECDH_CURVE25519_KEY_LENGTH];
+     for (jint i = 0; i < count; i += BATCH_CHUNK) {
+	  jint n = count - i < BATCH_CHUNK ? count - i : BATCH_CHUNK;
+	  jint off = i*ECDH_CURVE25519_KEY_LENGTH;
+	  env->GetByteArrayRegion(secret_keys_jobj, off,
+				  n*ECDH_CURVE25519_KEY_LENGTH,
+				  (jbyte *) secret_key);
+	  for (jint j = 0; j < n; j++)
+	       ecdh_curve25519_public_key(public_key[j], secret_key[j]);
+	  env->SetByteArrayRegion(out_jobj, off, n*ECDH_CURVE25519_KEY_LENGTH,
+				  (jbyte *) public_key);
+     }
+     memset(secret_key, 0, sizeof(secret_key));
+}
+
+static void JNICALL shared_secrets(JNIEnv *env, jclass ecdhcurve25519_jclass,
+				   jbyteArray my_secret_key_jobj,
+				   jbyteArray others_public_keys_jobj,
+				   jbyteArray out_jobj, jint count)
+{
+     if (!check_flat(env, my_secret_key_jobj, true, others_public_keys_jobj,
+		     out_jobj, count))
+	  return;
+
+     // ecdh_curve25519_shared_secret_batch takes one secret key per record
+     uint8_t my_secret_key[BATCH_CHUNK][ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t others_public_key[BATCH_CHUNK][ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t shared_secret[BATCH_CHUNK][ECDH_CURVE25519_KEY_LENGTH];
      env->GetByteArrayRegion(my_secret_key_jobj, 0, ECDH_CURVE25519_KEY_LENGTH,
-			     (jbyte *) my_secret_key);
-     env->GetByteArrayRegion(others_public_key_jobj, 0, 
-			     ECDH_CURVE25519_KEY_LENGTH, 
+			     (jbyte *) my_secret_key[0]);
+     for (int j = 1; j < BATCH_CHUNK; j++)
+	  memcpy(my_secret_key[j], my_secret_key[0],
+		 ECDH_CURVE25519_KEY_LENGTH);
+
+     for (jint i = 0; i < count; i += BATCH_CHUNK) {
+	  jint n = count - i < BATCH_CHUNK ? count - i : BATCH_CHUNK;
+	  jint off = i*ECDH_CURVE25519_KEY_LENGTH;
+	  env->GetByteArrayRegion(others_public_keys_jobj, off,
+				  n*ECDH_CURVE25519_KEY_LENGTH,
+				  (jbyte *) others_public_key);
+	  ecdh_curve25519_shared_secret_batch(shared_secret, my_secret_key,
+					      others_public_key, n);
+	  env->SetByteArrayRegion(out_jobj, off, n*ECDH_CURVE25519_KEY_LENGTH,
+				  (jbyte *) shared_secret);
+     }
+     memset(my_secret_key, 0, sizeof(my_secret_key));
+     memset(shared_secret, 0, sizeof(shared_secret));
+}
+
+static void create_pool(void)
+{
+     pool = ecdh_curve25519_pool_create(0);
+}
+
+// Like shared_secrets, but the records are spread over the threads of the
+// native pool, with the calling thread working as well. The whole batch is
+// copied out of the Java arrays first since the pool threads cannot call
+// JNI. Falls back to shared_secrets if there is no pool or no memory.
+static void JNICALL shared_secrets_parallel(JNIEnv *env,
+					    jclass ecdhcurve25519_jclass,
+					    jbyteArray my_secret_key_jobj,
+					    jbyteArray others_public_keys_jobj,
+					    jbyteArray out_jobj, jint count)
+{
+     if (!check_flat(env, my_secret_key_jobj, true, others_public_keys_jobj,
+		     out_jobj, count))
+	  return;
+
+     pthread_once(&pool_once, create_pool);
+     size_t len = (size_t) count*ECDH_CURVE25519_KEY_LENGTH;
+     uint8_t (*my_secret_key)[ECDH_CURVE25519_KEY_LENGTH] = NULL;
+     uint8_t (*others_public_key)[ECDH_CURVE25519_KEY_LENGTH] = NULL;
+     uint8_t (*shared_secret)[ECDH_CURVE25519_KEY_LENGTH] = NULL;
+     if (pool != NULL && count > 0) {
+	  my_secret_key = (uint8_t (*)[ECDH_CURVE25519_KEY_LENGTH]) malloc(len);
+	  others_public_key =
+	       (uint8_t (*)[ECDH_CURVE25519_KEY_LENGTH]) malloc(len);
+	  shared_secret = (uint8_t (*)[ECDH_CURVE25519_KEY_LENGTH]) malloc(len);
+     }
+     if (my_secret_key == NULL || others_public_key == NULL ||
+	 shared_secret == NULL) {
+	  free(my_secret_key);
+	  free(others_public_key);
+	  free(shared_secret);
+	  shared_secrets(env, ecdhcurve25519_jclass, my_secret_key_jobj,
+			 others_public_keys_jobj, out_jobj, count);
+	  return;
+     }
+
+     env->GetByteArrayRegion(my_secret_key_jobj, 0, ECDH_CURVE25519_KEY_LENGTH,
+			     (jbyte *) my_secret_key[0]);
+     for (jint j = 1; j < count; j++)
+	  memcpy(my_secret_key[j], my_secret_key[0],
+		 ECDH_CURVE25519_KEY_LENGTH);
+     env->GetByteArrayRegion(others_public_keys_jobj, 0, (jsize) len,
 			     (jbyte *) others_public_key);
-     
-     uint8_t shared_secret[ECDH_CURVE25519_KEY_LENGTH];
-     ecdh_curve25519_shared_secret(shared_secret, my_secret_key,
-				   others_public_key);
 
-     jbyteArray shared_secret_jobj = env->NewByteArray(
-	  ECDH_CURVE25519_KEY_LENGTH);
-     env->SetByteArrayRegion(shared_secret_jobj, 0, ECDH_CURVE25519_KEY_LENGTH, 
-			     (jbyte *) shared_secret);
-     
-     return shared_secret_jobj;
+     ecdh_curve25519_shared_secret_batch_parallel(pool, shared_secret,
+						  my_secret_key,
+						  others_public_key, count);
+
+     env->SetByteArrayRegion(out_jobj, 0, (jsize) len, (jbyte *) shared_secret);
+     memset(my_secret_key, 0, len);
+     memset(shared_secret, 0, len);
+     free(my_secret_key);
+     free(others_public_key);
+     free(shared_secret);
 }
 
+static const JNINativeMethod methods[] = {
+     {(char *) "secret_key_into", (char *) "([BI[BI)V",
+      (void *) secret_key_into},
+     {(char *) "public_key_into", (char *) "([BI[BI)V",
+      (void *) public_key_into},
+     {(char *) "shared_secret_into", (char *) "([BI[BI[BI)V",
+      (void *) shared_secret_into},
+     {(char *) "public_key_direct",
+      (char *) "(Ljava/nio/ByteBuffer;ILjava/nio/ByteBuffer;I)V",
+      (void *) public_key_direct},
+     {(char *) "shared_secret_direct",
+      (char *) "(Ljava/nio/ByteBuffer;ILjava/nio/ByteBuffer;I"
+      "Ljava/nio/ByteBuffer;I)V",
+      (void *) shared_secret_direct},
+     {(char *) "public_keys", (char *) "([B[BI)V", (void *) public_keys},
+     {(char *) "shared_secrets", (char *) "([B[B[BI)V",
+      (void *) shared_secrets},
+     {(char *) "shared_secrets_parallel", (char *) "([B[B[BI)V",
+      (void *) shared_secrets_parallel},
+};
+
+JNIEXPORT jint JNICALL JNI_OnLoad(JavaVM *vm, void *reserved)
+{
+     JNIEnv *env;
+     if (vm->GetEnv((void **) &env, JNI_VERSION_1_6) != JNI_OK)
+	  return JNI_ERR;
+
+     jclass exception = env->FindClass("java/security/InvalidParameterException");
+     if (exception == NULL)
+	  return JNI_ERR;
+     invalid_parameter_exception = (jclass) env->NewGlobalRef(exception);
+     env->DeleteLocalRef(exception);
+     if (invalid_parameter_exception == NULL)
+	  return JNI_ERR;
+
+     jclass ecdhcurve25519_jclass = env->FindClass(CLASS_NAME);
+     if (ecdhcurve25519_jclass == NULL)
+	  return JNI_ERR;
+     jint err = env->RegisterNatives(ecdhcurve25519_jclass, methods,
+				     sizeof(methods)/sizeof(methods[0]));
+     env->DeleteLocalRef(ecdhcurve25519_jclass);
+     if (err != JNI_OK)
+	  return JNI_ERR;
+
+     return JNI_VERSION_1_6;
+}
+
+JNIEXPORT void JNICALL JNI_OnUnload(JavaVM *vm, void *reserved)
+{
+     JNIEnv *env;
+     if (vm->GetEnv((void **) &env, JNI_VERSION_1_6) != JNI_OK)
+	  return;
+     env->DeleteGlobalRef(invalid_parameter_exception);
+     invalid_parameter_exception = NULL;
+     if (pool != NULL) {
+	  ecdh_curve25519_pool_destroy(pool);
+	  pool = NULL;
+     }
+}
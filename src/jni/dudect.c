@@ -0,0 +1,363 @@
+/**
+ * This file is part of ECDH-Curve25519-Mobile.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+
+/*
+ * Timing leakage test in the style of dudect (Reparaz, Balasch and
+ * Verbauwhede, "Dude, is my code constant time?", DATE 2017).
+ *
+ * For every implementation of crypto_scalarmult_curve25519 the CPU
+ * supports, for crypto_scalarmult_curve25519_base ("base"), for the
+ * multiplication with a precomputed table of the peer's point behind
+ * ecdh_curve25519_shared_secret_with_ctx ("ctx"), and for the 4-way AVX2
+ * kernel behind the batch functions ("avx2x4"), the execution time is
+ * measured for two classes of secret scalars: one fixed scalar, and fresh
+ * random scalars. The classes are interleaved in random order, and the
+ * point is the same for both. Welch's t-test compares the two timing
+ * distributions. It is run on all measurements, and again on the
+ * measurements below several percentiles, because long outliers from
+ * interrupts hide small differences. A |t| above the threshold (default
+ * 4.5) is evidence that the time depends on the secret. The program then
+ * exits with status 1.
+ *
+ * A passing test does not prove that the code is constant time. It only
+ * shows that no difference was found with this many measurements on this
+ * CPU.
+ *
+ * Usage: dudect [-n measurements] [-i implementation] [-t threshold]
+ *               [-c cpu]
+ */
+
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <math.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+#include "avrnacl.h"
+#include "curve25519_avx2.h"
+#include "curve25519_dispatch.h"
+#include "curve25519_precomp.h"
+
+#define BATCH 1000
+#define PERCENTILES 10
+#define TESTS (1 + PERCENTILES)
+#define MIN_SAMPLES 1000
+
+/* Welch's t-test on the fly (Welford's method for mean and variance) */
+typedef struct {
+     double mean[2];
+     double m2[2];
+     double n[2];
+} ttest;
+
+typedef struct {
+     const char *name;
+     int (*scalarmult)(unsigned char *r, const unsigned char *s,
+                       const unsigned char *p);
+     /* Chooses the point, or NULL for a random one; returns 0 on success */
+     int (*prepare)(unsigned char *p);
+     /* Whether name is an implementation of crypto_scalarmult_curve25519 */
+     int dispatch;
+} target;
+
+static unsigned int measurements = 20000;
+static double threshold = 4.5;
+
+static uint64_t prng_state = 0x2545f4914f6cdd1dULL;
+
+static uint64_t prng(void)
+{
+     prng_state ^= prng_state << 13;
+     prng_state ^= prng_state >> 7;
+     prng_state ^= prng_state << 17;
+     return prng_state;
+}
+
+static void random_bytes(unsigned char *r, size_t len)
+{
+     for (size_t i = 0; i < len; i++)
+          r[i] = (unsigned char) (prng() >> 24);
+}
+
+/* Time stamp: the time-stamp counter on x86, nanoseconds otherwise */
+static uint64_t timestamp(void)
+{
+#if defined(__x86_64__) || defined(__i386__)
+     return __rdtsc();
+#else
+     struct timespec ts;
+     clock_gettime(CLOCK_MONOTONIC, &ts);
+     return (uint64_t) ts.tv_sec*1000000000 + ts.tv_nsec;
+#endif
+}
+
+static void ttest_push(ttest *t, double x, int c)
+{
+     t->n[c]++;
+     double delta = x - t->mean[c];
+     t->mean[c] += delta/t->n[c];
+     t->m2[c] += delta*(x - t->mean[c]);
+}
+
+static double ttest_value(const ttest *t)
+{
+     if (t->n[0] < 2 || t->n[1] < 2)
+          return 0;
+     double v0 = t->m2[0]/(t->n[0] - 1);
+     double v1 = t->m2[1]/(t->n[1] - 1);
+     double den = sqrt(v0/t->n[0] + v1/t->n[1]);
+     if (den == 0)
+          return 0;
+     return (t->mean[0] - t->mean[1])/den;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+     double x = *(const double *) a;
+     double y = *(const double *) b;
+     return (x > y) - (x < y);
+}
+
+/* Run the test on one function; returns the largest |t| and stores the
+ * number of measurements in the test it came from in *samples. */
+static double run(const target *tg, double *samples)
+{
+     static unsigned char secret[BATCH][32];
+     static unsigned char classes[BATCH];
+     static double times[BATCH];
+     static double sorted[BATCH];
+     unsigned char fixed[32];
+     unsigned char point[32];
+     unsigned char r[32];
+     ttest tests[TESTS];
+     double cutoff[PERCENTILES];
+
+     memset(tests, 0, sizeof(tests));
+     memset(fixed, 0, sizeof(fixed));
+     random_bytes(point, sizeof(point));
+     point[31] &= 127;
+     if (tg->prepare != NULL && tg->prepare(point) != 0) {
+          *samples = 0;
+          return -1;
+     }
+
+     for (unsigned int done = 0, batch = 0; done < measurements; batch++) {
+          for (int i = 0; i < BATCH; i++) {
+               classes[i] = prng() & 1;
+               if (classes[i] == 0)
+                    memcpy(secret[i], fixed, 32);
+               else
+                    random_bytes(secret[i], 32);
+          }
+          for (int i = 0; i < BATCH; i++) {
+               uint64_t t0 = timestamp();
+               tg->scalarmult(r, secret[i], point);
+               uint64_t t1 = timestamp();
+               times[i] = (double) (t1 - t0);
+          }
+          /* The first batch warms up the caches and sets the percentiles */
+          if (batch == 0) {
+               memcpy(sorted, times, sizeof(times));
+               qsort(sorted, BATCH, sizeof(double), compare_double);
+               for (int j = 0; j < PERCENTILES; j++) {
+                    double q = 1 - pow(0.5, 10.0*(j + 1)/PERCENTILES);
+                    cutoff[j] = sorted[(int) (q*(BATCH - 1))];
+               }
+               continue;
+          }
+          for (int i = 0; i < BATCH; i++) {
+               ttest_push(&tests[0], times[i], classes[i]);
+               for (int j = 0; j < PERCENTILES; j++)
+                    if (times[i] < cutoff[j])
+                         ttest_push(&tests[1 + j], times[i], classes[i]);
+          }
+          done += BATCH;
+     }
+
+     double max_t = 0;
+     *samples = 0;
+     for (int j = 0; j < TESTS; j++) {
+          double n = tests[j].n[0] + tests[j].n[1];
+          double t = fabs(ttest_value(&tests[j]));
+          if (n >= MIN_SAMPLES && t > max_t) {
+               max_t = t;
+               *samples = n;
+          }
+     }
+     return max_t;
+}
+
+/* Fixed-base multiplication with the signature of crypto_scalarmult */
+static int scalarmult_base(unsigned char *r, const unsigned char *s,
+                           const unsigned char *p)
+{
+     (void) p;
+     return crypto_scalarmult_curve25519_base(r, s);
+}
+
+static crypto_scalarmult_curve25519_precomp_ctx precomp;
+
+/* The table is only built for points on the curve, not on the twist, so
+ * take a public key as the point. */
+static int prepare_precomp(unsigned char *p)
+{
+     unsigned char s[32];
+     random_bytes(s, sizeof(s));
+     crypto_scalarmult_curve25519_base(p, s);
+     crypto_scalarmult_curve25519_precompute(&precomp, p);
+     return precomp.use_table ? 0 : -1;
+}
+
+static int scalarmult_precomp(unsigned char *r, const unsigned char *s,
+                              const unsigned char *p)
+{
+     (void) p;
+     return crypto_scalarmult_curve25519_precomp(r, s, &precomp);
+}
+
+#if defined(CURVE25519_AVX2)
+/* The 4-way kernel with the scalar and the point in every lane */
+static int scalarmult_avx2_x4(unsigned char *r, const unsigned char *s,
+                              const unsigned char *p)
+{
+     unsigned char r4[4][32], s4[4][32], p4[4][32];
+     for (int k = 0; k < 4; k++) {
+          memcpy(s4[k], s, 32);
+          memcpy(p4[k], p, 32);
+     }
+     int ret = crypto_scalarmult_curve25519_avx2_x4(r4, s4, p4);
+     memcpy(r, r4[0], 32);
+     return ret;
+}
+#endif
+
+static void usage(const char *prog)
+{
+     fprintf(stderr,
+             "usage: %s [-n measurements] [-i implementation] "
+             "[-t threshold] [-c cpu]\n"
+             "  -n measurements    per implementation (default %u)\n"
+             "  -i implementation  only this implementation (or \"base\", \"ctx\",\n"
+             "                     \"avx2x4\")\n"
+             "  -t threshold       largest acceptable |t| (default %.1f)\n"
+             "  -c cpu             pin the process to this CPU\n",
+             prog, measurements, threshold);
+}
+
+int main(int argc, char *argv[])
+{
+     const char *only = NULL;
+     target targets[19];
+     int ntargets = 0;
+     int leaks = 0;
+     int cpu = -1;
+     int opt;
+
+     while ((opt = getopt(argc, argv, "n:i:t:c:h")) != -1) {
+          switch (opt) {
+          case 'n': measurements = (unsigned int) atoi(optarg); break;
+          case 'i': only = optarg; break;
+          case 't': threshold = atof(optarg); break;
+          case 'c': cpu = atoi(optarg); break;
+          default: usage(argv[0]); return 2;
+          }
+     }
+     if (measurements == 0) {
+          usage(argv[0]);
+          return 2;
+     }
+
+     if (cpu >= 0) {
+          cpu_set_t set;
+          CPU_ZERO(&set);
+          CPU_SET(cpu, &set);
+          if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+               fprintf(stderr, "cannot pin to CPU %d: %s\n", cpu,
+                       strerror(errno));
+               return 1;
+          }
+     }
+
+     for (int i = 0; ntargets < 16; i++) {
+          const char *name = crypto_scalarmult_curve25519_implementation_name(i);
+          if (name == NULL)
+               break;
+          if (only == NULL || strcmp(only, name) == 0) {
+               targets[ntargets++] = (target) {
+                    name, crypto_scalarmult_curve25519, NULL, 1
+               };
+          }
+     }
+     if (only == NULL || strcmp(only, "base") == 0)
+          targets[ntargets++] = (target) { "base", scalarmult_base, NULL, 0 };
+     if (only == NULL || strcmp(only, "ctx") == 0)
+          targets[ntargets++] = (target) {
+               "ctx", scalarmult_precomp, prepare_precomp, 0
+          };
+#if defined(CURVE25519_AVX2)
+     if ((only == NULL || strcmp(only, "avx2x4") == 0) &&
+         crypto_scalarmult_curve25519_avx2_supported())
+          targets[ntargets++] = (target) {
+               "avx2x4", scalarmult_avx2_x4, NULL, 0
+          };
+#endif
+     if (ntargets == 0) {
+          fprintf(stderr, "implementation %s is not supported\n", only);
+          return 1;
+     }
+
+     printf("%-10s %12s %10s  %s\n", "impl", "samples", "max |t|", "result");
+     for (int i = 0; i < ntargets; i++) {
+          const target *tg = &targets[i];
+          double samples;
+          if (tg->dispatch)
+               crypto_scalarmult_curve25519_select(tg->name);
+          double t = run(tg, &samples);
+          if (t < 0) {
+               printf("%-10s cannot prepare the point\n", tg->name);
+               leaks++;
+               continue;
+          }
+          int leak = t > threshold;
+          printf("%-10s %12.0f %10.2f  %s\n", tg->name, samples, t,
+                 leak ? "LEAKAGE" : "ok");
+          fflush(stdout);
+          leaks += leak;
+     }
+     crypto_scalarmult_curve25519_select(NULL);
+     return leaks ? 1 : 0;
+}
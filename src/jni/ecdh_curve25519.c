@@ -31,13 +31,16 @@
 
 #include "ecdh_curve25519.h"
 #include "avrnacl.h"
+#include "curve25519_dispatch.h"
+#include "curve25519_precomp.h"
+#include "curve25519_pool.h"
 #include <string.h>
 
 void ecdh_curve25519_secret_key(
      uint8_t secret_key[ECDH_CURVE25519_KEY_LENGTH],
      const uint8_t random[ECDH_CURVE25519_KEY_LENGTH])
 {
-     memcpy(secret_key, random, sizeof(secret_key));
+     memcpy(secret_key, random, ECDH_CURVE25519_KEY_LENGTH);
 
      // We need to clear bits 0-2 and set bit 254 to prevent small-subgroup 
      // attacks and timing attacks, respectively:
@@ -63,3 +66,62 @@ void ecdh_curve25519_shared_secret(
      crypto_scalarmult_curve25519(shared_secret, my_secret_key, 
 				  other_public_key);
 }
+
+// The public context type only reserves the space of the internal one.
+typedef char peer_ctx_size_check[
+     (ECDH_CURVE25519_PEER_CTX_LENGTH ==
+      crypto_scalarmult_curve25519_PRECOMPBYTES) ? 1 : -1];
+
+void ecdh_curve25519_peer_precompute(
+     ecdh_curve25519_peer_ctx *ctx,
+     const uint8_t other_public_key[ECDH_CURVE25519_KEY_LENGTH])
+{
+     crypto_scalarmult_curve25519_precompute(
+	  (crypto_scalarmult_curve25519_precomp_ctx *) ctx->opaque,
+	  other_public_key);
+}
+
+void ecdh_curve25519_shared_secret_with_ctx(
+     uint8_t shared_secret[ECDH_CURVE25519_KEY_LENGTH],
+     const uint8_t my_secret_key[ECDH_CURVE25519_KEY_LENGTH],
+     const ecdh_curve25519_peer_ctx *ctx)
+{
+     crypto_scalarmult_curve25519_precomp(shared_secret, my_secret_key,
+	  (const crypto_scalarmult_curve25519_precomp_ctx *) ctx->opaque);
+}
+
+void ecdh_curve25519_shared_secret_batch(
+     uint8_t shared_secret[][ECDH_CURVE25519_KEY_LENGTH],
+     const uint8_t my_secret_key[][ECDH_CURVE25519_KEY_LENGTH],
+     const uint8_t other_public_key[][ECDH_CURVE25519_KEY_LENGTH],
+     size_t n)
+{
+     crypto_scalarmult_curve25519_batch(shared_secret, my_secret_key,
+					other_public_key, n);
+}
+
+ecdh_curve25519_pool *ecdh_curve25519_pool_create(unsigned int threads)
+{
+     return crypto_scalarmult_curve25519_pool_create(threads);
+}
+
+void ecdh_curve25519_pool_destroy(ecdh_curve25519_pool *pool)
+{
+     crypto_scalarmult_curve25519_pool_destroy(pool);
+}
+
+void ecdh_curve25519_shared_secret_batch_parallel(
+     ecdh_curve25519_pool *pool,
+     uint8_t shared_secret[][ECDH_CURVE25519_KEY_LENGTH],
+     const uint8_t my_secret_key[][ECDH_CURVE25519_KEY_LENGTH],
+     const uint8_t other_public_key[][ECDH_CURVE25519_KEY_LENGTH],
+     size_t n)
+{
+     crypto_scalarmult_curve25519_pool_batch(pool, shared_secret, my_secret_key,
+					     other_public_key, n);
+}
+
+const char *ecdh_curve25519_implementation(void)
+{
+     return crypto_scalarmult_curve25519_implementation();
+}
@@ -32,10 +32,28 @@
 #ifndef ECDH_CURVE25519_H
 #define ECDH_CURVE25519_H
 
+#include <stddef.h>
 #include <stdint.h>
 
 #define ECDH_CURVE25519_KEY_LENGTH 32
 
+#define ECDH_CURVE25519_PEER_CTX_LENGTH (32*8*96 + 32 + 1)
+
+/**
+ * Precomputed data for a public key that is used for many key exchanges,
+ * see ecdh_curve25519_peer_precompute(). The content is private to the
+ * library; the context can be copied with memcpy.
+ */
+typedef struct {
+     uint8_t opaque[ECDH_CURVE25519_PEER_CTX_LENGTH];
+} ecdh_curve25519_peer_ctx;
+
+/**
+ * Worker threads for computing large batches of shared secrets in
+ * parallel, see ecdh_curve25519_pool_create().
+ */
+typedef struct crypto_scalarmult_curve25519_pool ecdh_curve25519_pool;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -75,6 +93,94 @@ void ecdh_curve25519_shared_secret(
      const uint8_t my_secret_key[ECDH_CURVE25519_KEY_LENGTH],
      const uint8_t other_public_key[ECDH_CURVE25519_KEY_LENGTH]);
 
+/**
+ * Prepare a context for calculating shared secrets with a long-lived
+ * public key (e.g., the static key of a server). Building the context costs
+ * about as much as five calls of ecdh_curve25519_shared_secret; afterwards,
+ * ecdh_curve25519_shared_secret_with_ctx is considerably faster.
+ *
+ * @param ctx the context to fill.
+ * @param other_public_key the public key of the other entity.
+ */
+void ecdh_curve25519_peer_precompute(
+     ecdh_curve25519_peer_ctx *ctx,
+     const uint8_t other_public_key[ECDH_CURVE25519_KEY_LENGTH]);
+
+/**
+ * Calculate the shared secret from an entity's secret key and a public key
+ * prepared with ecdh_curve25519_peer_precompute(). The result is the same
+ * as that of ecdh_curve25519_shared_secret.
+ *
+ * @param shared_secret the shared secret.
+ * @param my_secret_key secret key of the entity calculating the shared secret.
+ * @param ctx the prepared public key of the other entity.
+ */
+void ecdh_curve25519_shared_secret_with_ctx(
+     uint8_t shared_secret[ECDH_CURVE25519_KEY_LENGTH],
+     const uint8_t my_secret_key[ECDH_CURVE25519_KEY_LENGTH],
+     const ecdh_curve25519_peer_ctx *ctx);
+
+/**
+ * Calculate n shared secrets at once: shared_secret[i] is the shared secret
+ * of my_secret_key[i] and other_public_key[i]. Faster per secret than
+ * calling ecdh_curve25519_shared_secret n times.
+ *
+ * @param shared_secret the n shared secrets.
+ * @param my_secret_key n secret keys.
+ * @param other_public_key n public keys of the other entities.
+ * @param n number of key pairs.
+ */
+void ecdh_curve25519_shared_secret_batch(
+     uint8_t shared_secret[][ECDH_CURVE25519_KEY_LENGTH],
+     const uint8_t my_secret_key[][ECDH_CURVE25519_KEY_LENGTH],
+     const uint8_t other_public_key[][ECDH_CURVE25519_KEY_LENGTH],
+     size_t n);
+
+/**
+ * Create a pool of worker threads for
+ * ecdh_curve25519_shared_secret_batch_parallel(). The threads are created
+ * once and reused by every batch.
+ *
+ * @param threads number of threads a batch runs on, including the calling
+ * thread; 0 means one per online CPU.
+ * @return the pool, or NULL if the threads could not be created.
+ */
+ecdh_curve25519_pool *ecdh_curve25519_pool_create(unsigned int threads);
+
+/**
+ * Stop the threads of a pool and free it. No batch may be running.
+ *
+ * @param pool the pool.
+ */
+void ecdh_curve25519_pool_destroy(ecdh_curve25519_pool *pool);
+
+/**
+ * Like ecdh_curve25519_shared_secret_batch(), but the key pairs are
+ * distributed over the threads of a pool. The calling thread works as well
+ * and returns when all shared secrets are done. Batches submitted to the
+ * same pool from several threads run one after the other.
+ *
+ * @param pool the pool.
+ * @param shared_secret the n shared secrets.
+ * @param my_secret_key n secret keys.
+ * @param other_public_key n public keys of the other entities.
+ * @param n number of key pairs.
+ */
+void ecdh_curve25519_shared_secret_batch_parallel(
+     ecdh_curve25519_pool *pool,
+     uint8_t shared_secret[][ECDH_CURVE25519_KEY_LENGTH],
+     const uint8_t my_secret_key[][ECDH_CURVE25519_KEY_LENGTH],
+     const uint8_t other_public_key[][ECDH_CURVE25519_KEY_LENGTH],
+     size_t n);
+
+/**
+ * Name of the Curve25519 implementation selected for this CPU, e.g. "mulx"
+ * or "radix51".
+ *
+ * @return implementation name (static string).
+ */
+const char *ecdh_curve25519_implementation(void);
+
 #ifdef __cplusplus
 }
 #endif
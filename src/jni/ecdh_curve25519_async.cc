@@ -0,0 +1,152 @@
+/**
+ * This file is part of ECDH-Curve25519-Mobile.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+
+#include "ecdh_curve25519_async.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <system_error>
+#if defined(__linux__)
+#include <sys/eventfd.h>
+#endif
+
+namespace ecdh_curve25519 {
+
+executor::executor(unsigned int n)
+{
+     if (n == 0)
+	  n = std::thread::hardware_concurrency();
+     if (n == 0)
+	  n = 1;
+     for (unsigned int i = 0; i < n; i++)
+	  threads.emplace_back([this] { run(); });
+}
+
+executor::~executor()
+{
+     {
+	  std::lock_guard<std::mutex> guard(lock);
+	  stopping = true;
+     }
+     work.notify_all();
+     for (std::thread &t : threads)
+	  t.join();
+}
+
+void executor::submit(std::function<void()> job)
+{
+     {
+	  std::lock_guard<std::mutex> guard(lock);
+	  jobs.push_back(std::move(job));
+     }
+     work.notify_one();
+}
+
+void executor::run()
+{
+     for (;;) {
+	  std::function<void()> job;
+	  {
+	       std::unique_lock<std::mutex> guard(lock);
+	       work.wait(guard, [this] { return stopping || !jobs.empty(); });
+	       if (jobs.empty())
+		    return;
+	       job = std::move(jobs.front());
+	       jobs.pop_front();
+	  }
+	  job();
+     }
+}
+
+// On Linux, one eventfd is both ends; elsewhere a non-blocking pipe.
+completion_queue::completion_queue()
+{
+#if defined(__linux__)
+     read_fd = write_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+     if (read_fd < 0)
+	  throw std::system_error(errno, std::generic_category(), "eventfd");
+#else
+     int fds[2];
+     if (pipe(fds) != 0)
+	  throw std::system_error(errno, std::generic_category(), "pipe");
+     for (int i = 0; i < 2; i++) {
+	  fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+	  fcntl(fds[i], F_SETFD, FD_CLOEXEC);
+     }
+     read_fd = fds[0];
+     write_fd = fds[1];
+#endif
+}
+
+completion_queue::~completion_queue()
+{
+     close(read_fd);
+     if (write_fd != read_fd)
+	  close(write_fd);
+}
+
+void completion_queue::push(std::coroutine_handle<> handle)
+{
+     bool was_empty;
+     {
+	  std::lock_guard<std::mutex> guard(lock);
+	  was_empty = ready.empty();
+	  ready.push_back(handle);
+     }
+     // One notification per batch of ready coroutines is enough; run()
+     // takes all of them.
+     if (was_empty) {
+	  uint64_t one = 1;
+	  ssize_t written;
+	  do {
+	       written = write(write_fd, &one, write_fd == read_fd ?
+			       sizeof(one) : 1);
+	  } while (written < 0 && errno == EINTR);
+     }
+}
+
+std::size_t completion_queue::run()
+{
+     std::vector<std::coroutine_handle<>> handles;
+     {
+	  std::lock_guard<std::mutex> guard(lock);
+	  handles.swap(ready);
+	  // Reset the notification while holding the lock, so that a push
+	  // after the swap notifies again.
+	  uint64_t buf[8];
+	  while (read(read_fd, buf, write_fd == read_fd ? sizeof(uint64_t) :
+		      sizeof(buf)) > 0)
+	       ;
+     }
+     for (std::coroutine_handle<> handle : handles)
+	  handle.resume();
+     return handles.size();
+}
+
+} // namespace ecdh_curve25519
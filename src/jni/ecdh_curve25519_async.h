@@ -0,0 +1,209 @@
+/**
+ * This file is part of ECDH-Curve25519-Mobile.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+
+#ifndef ECDH_CURVE25519_ASYNC_H
+#define ECDH_CURVE25519_ASYNC_H
+
+// C++20 coroutine interface to the functions of ecdh_curve25519.h. The
+// scalar multiplications run on the threads of an executor, so that the
+// thread awaiting them, e.g. the reactor thread of an epoll-based server,
+// is free to do other work in the meantime:
+//
+//     ecdh_curve25519::executor exec;
+//     ecdh_curve25519::completion_queue done;  // done.fd() is in the epoll set
+//
+//     task handshake(connection &c) {
+//          ecdh_curve25519::key secret = ...;
+//          ecdh_curve25519::key shared =
+//               co_await ecdh_curve25519::shared_secret(exec, secret,
+//                                                       c.peer_key, &done);
+//          ...
+//     }
+//
+//     // in the event loop, when done.fd() is readable:
+//     done.run();
+//
+// Without a completion queue, the awaiting coroutine is resumed on the
+// executor thread that finished the operation. Any number of operations
+// may be outstanding at the same time; each coroutine is resumed when its
+// own operation is done. The inputs are copied into the awaitable, so they
+// need not outlive the co_await expression; the arrays of shared_secrets()
+// must stay valid until it completes.
+//
+// An executor thread may still be running the tail of a job (the push to the
+// completion queue, or the rest of a coroutine resumed inline) when the
+// awaiting side already sees the result. Destroy the executor, which joins
+// its threads, before the completion queue and anything those jobs touch.
+
+#include <array>
+#include <condition_variable>
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "ecdh_curve25519.h"
+
+namespace ecdh_curve25519 {
+
+typedef std::array<uint8_t, ECDH_CURVE25519_KEY_LENGTH> key;
+
+// Fixed set of threads running submitted jobs in FIFO order.
+class executor {
+public:
+     // threads = 0 means one per hardware thread.
+     explicit executor(unsigned int threads = 0);
+     // Runs the jobs still queued, then joins the threads.
+     ~executor();
+
+     executor(const executor &) = delete;
+     executor &operator=(const executor &) = delete;
+
+     void submit(std::function<void()> job);
+
+private:
+     void run();
+
+     std::mutex lock;
+     std::condition_variable work;
+     std::deque<std::function<void()>> jobs;
+     std::vector<std::thread> threads;
+     bool stopping = false;
+};
+
+// Coroutines whose operation is done, waiting to be resumed by the thread
+// calling run(). fd() becomes readable when there are such coroutines, so
+// it can be watched with epoll, poll or select.
+class completion_queue {
+public:
+     completion_queue();
+     ~completion_queue();
+
+     completion_queue(const completion_queue &) = delete;
+     completion_queue &operator=(const completion_queue &) = delete;
+
+     int fd() const { return read_fd; }
+
+     // Resume the waiting coroutines on the calling thread; returns how
+     // many were resumed. Does not block.
+     std::size_t run();
+
+     // Called by the executor threads
+     void push(std::coroutine_handle<> handle);
+
+private:
+     std::mutex lock;
+     std::vector<std::coroutine_handle<>> ready;
+     int read_fd;
+     int write_fd;
+};
+
+// Awaitable running f(result) on an executor; co_await yields the result.
+template <typename Result, typename F>
+class operation {
+public:
+     operation(executor &exec, completion_queue *queue, F f)
+	  : exec(exec), queue(queue), f(std::move(f)) {}
+
+     bool await_ready() const noexcept { return false; }
+
+     void await_suspend(std::coroutine_handle<> handle)
+     {
+	  exec.submit([this, handle] {
+	       f(result);
+	       if (queue != nullptr)
+		    queue->push(handle);
+	       else
+		    handle.resume();
+	  });
+     }
+
+     Result await_resume() { return std::move(result); }
+
+private:
+     executor &exec;
+     completion_queue *queue;
+     F f;
+     Result result{};
+};
+
+// co_await public_key(exec, secret_key) yields the public key.
+inline auto public_key(executor &exec, const key &secret_key,
+		       completion_queue *queue = nullptr)
+{
+     auto f = [secret_key](key &public_key) {
+	  ecdh_curve25519_public_key(public_key.data(), secret_key.data());
+     };
+     return operation<key, decltype(f)>(exec, queue, std::move(f));
+}
+
+// co_await shared_secret(exec, my_secret_key, other_public_key) yields the
+// shared secret.
+inline auto shared_secret(executor &exec, const key &my_secret_key,
+			  const key &other_public_key,
+			  completion_queue *queue = nullptr)
+{
+     auto f = [my_secret_key, other_public_key](key &shared_secret) {
+	  ecdh_curve25519_shared_secret(shared_secret.data(),
+					my_secret_key.data(),
+					other_public_key.data());
+     };
+     return operation<key, decltype(f)>(exec, queue, std::move(f));
+}
+
+// co_await shared_secrets(exec, out, my_secret_key, other_public_key, n)
+// computes n shared secrets with ecdh_curve25519_shared_secret_batch in one
+// job, which is faster than n separate operations.
+inline auto shared_secrets(executor &exec, key *shared_secret,
+			   const key *my_secret_key,
+			   const key *other_public_key, std::size_t n,
+			   completion_queue *queue = nullptr)
+{
+     static_assert(sizeof(key) == ECDH_CURVE25519_KEY_LENGTH,
+		   "key must be a plain array");
+     auto f = [=](bool &) {
+	  ecdh_curve25519_shared_secret_batch(
+	       reinterpret_cast<uint8_t (*)[ECDH_CURVE25519_KEY_LENGTH]>(
+		    shared_secret),
+	       reinterpret_cast<const uint8_t (*)[ECDH_CURVE25519_KEY_LENGTH]>(
+		    my_secret_key),
+	       reinterpret_cast<const uint8_t (*)[ECDH_CURVE25519_KEY_LENGTH]>(
+		    other_public_key),
+	       n);
+     };
+     return operation<bool, decltype(f)>(exec, queue, std::move(f));
+}
+
+} // namespace ecdh_curve25519
+
+#endif
@@ -13,6 +13,14 @@
 #include "bigint.h"
 #include "fe25519.h"
 
+// Modifications compared to avrnacl: this byte-oriented implementation is
+// only compiled if FE25519_RADIX8 is selected in fe25519.h. The inversion and
+// exponentiation chains were moved to fe25519_pow.c. fe25519_iszero also
+// checks the lowest byte and returns 1 (not 65535) for zero. fe25519_square
+// uses a dedicated squaring, fe25519_mul121666 a single pass over the bytes.
+
+#if defined(FE25519_RADIX8)
+
 /******************************************************************/
 /*                Static constants and functions                  */
 /******************************************************************/
@@ -26,8 +34,8 @@ static const unsigned char ECCParam_p[32] = {0xED, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
 static crypto_uint16 equal(crypto_uint16 a,crypto_uint16 b) /* 8-bit inputs */
 {
   crypto_uint32 x = a ^ b; /* 0: yes; 1..255: no */
-  x -= 1; /* 65535: yes; 0..254: no */
-  x >>= 16; /* 1: yes; 0: no */
+  x -= 1; /* 4294967295: yes; 0..254: no */
+  x >>= 31; /* 1: yes; 0: no */
   return x;
 }
 
@@ -76,15 +84,10 @@ void fe25519_sub(fe25519 *r, const fe25519 *a, const fe25519 *b)
   }
 }
 
-void fe25519_mul(fe25519 *r, const fe25519 *a, const fe25519 *b) 
+/* r = t mod 2^255-19 (weakly reduced) for a 512-bit t */
+static void reduce(fe25519 *r, const unsigned char t[64])
 {
-  unsigned char t[64];
   crypto_uint16 UV=0;
-
-  /* multiplication */
-  bigint_mul32(t, a->v, b->v);
-	
-  /* reduction */
   int i;
   for (i=0; i<32; i++) 
   {
@@ -106,12 +109,53 @@ void fe25519_mul(fe25519 *r, const fe25519 *a, const fe25519 *b)
   	r->v[i] = (UV & 0xFF);
     UV >>= 8;
   }
+}
+
+void fe25519_mul(fe25519 *r, const fe25519 *a, const fe25519 *b) 
+{
+  unsigned char t[64];
 
+  /* multiplication */
+  bigint_mul32(t, a->v, b->v);
+	
+  /* reduction */
+  reduce(r, t);
+}
+
+void fe25519_mul121666(fe25519 *r, const fe25519 *x)
+{
+  crypto_uint32 UV=0;
+  int i;
+
+  /* 121666 < 2^17, so the carry out of the top byte is below 2^17 */
+  for (i=0; i<32; i++) 
+  {
+    UV += (crypto_uint32)x->v[i] * 121666;
+    r->v[i] = (UV & 0xFF);
+    UV >>= 8;
+  }
+  UV *= 38;
+  for (i=0; i<32; i++) 
+  {
+    UV = UV + r->v[i];
+    r->v[i] = (UV & 0xFF);
+    UV >>= 8;
+  }
+  UV *= 38;
+  /* a carry out of the second pass leaves a value below 2^23 */
+  for (i=0; i<3; i++)
+  {
+    UV = UV + r->v[i];
+    r->v[i] = (UV & 0xFF);
+    UV >>= 8;
+  }
 }
 
 void fe25519_square(fe25519 *r, const fe25519 *x) 
 {
-  fe25519_mul(r,x,x);
+  unsigned char t[64];
+  bigint_square32(t, x->v);
+  reduce(r, t);
 }
 
 void fe25519_setzero(fe25519 *r)
@@ -142,7 +186,7 @@ int fe25519_iszero(const fe25519 *x)
   unsigned char r = 0;
   fe25519 t = *x;
   fe25519_freeze(&t);
-  for(i=1;i<32;i++)
+  for(i=0;i<32;i++)
     r |= t.v[i];
   return equal(r,0);
 }
@@ -198,123 +242,4 @@ void fe25519_freeze(fe25519 *r)
   fe25519_cmov(r,&rt,1-c);
 }
 
-void fe25519_invert(fe25519 *r, const fe25519 *x)
-{
-	fe25519 z2;
-	fe25519 z9;
-	fe25519 z11;
-	fe25519 z2_5_0;
-	fe25519 z2_10_0;
-	fe25519 z2_20_0;
-	fe25519 z2_50_0;
-	fe25519 z2_100_0;
-	fe25519 t0;
-	fe25519 t1;
-	int i;
-
-	/* 2 */ fe25519_square(&z2,x);
-	/* 4 */ fe25519_square(&t1,&z2);
-	/* 8 */ fe25519_square(&t0,&t1);
-	/* 9 */ fe25519_mul(&z9,&t0,x);
-	/* 11 */ fe25519_mul(&z11,&z9,&z2);
-	/* 22 */ fe25519_square(&t0,&z11);
-	/* 2^5 - 2^0 = 31 */ fe25519_mul(&z2_5_0,&t0,&z9);
-
-	/* 2^6 - 2^1 */ fe25519_square(&t0,&z2_5_0);
-	/* 2^7 - 2^2 */ fe25519_square(&t1,&t0);
-	/* 2^8 - 2^3 */ fe25519_square(&t0,&t1);
-	/* 2^9 - 2^4 */ fe25519_square(&t1,&t0);
-	/* 2^10 - 2^5 */ fe25519_square(&t0,&t1);
-	/* 2^10 - 2^0 */ fe25519_mul(&z2_10_0,&t0,&z2_5_0);
-
-	/* 2^11 - 2^1 */ fe25519_square(&t0,&z2_10_0);
-	/* 2^12 - 2^2 */ fe25519_square(&t1,&t0);
-	/* 2^20 - 2^10 */ for (i = 2;i < 10;i += 2) { fe25519_square(&t0,&t1); fe25519_square(&t1,&t0); }
-	/* 2^20 - 2^0 */ fe25519_mul(&z2_20_0,&t1,&z2_10_0);
-
-	/* 2^21 - 2^1 */ fe25519_square(&t0,&z2_20_0);
-	/* 2^22 - 2^2 */ fe25519_square(&t1,&t0);
-	/* 2^40 - 2^20 */ for (i = 2;i < 20;i += 2) { fe25519_square(&t0,&t1); fe25519_square(&t1,&t0); }
-	/* 2^40 - 2^0 */ fe25519_mul(&t0,&t1,&z2_20_0);
-
-	/* 2^41 - 2^1 */ fe25519_square(&t1,&t0);
-	/* 2^42 - 2^2 */ fe25519_square(&t0,&t1);
-	/* 2^50 - 2^10 */ for (i = 2;i < 10;i += 2) { fe25519_square(&t1,&t0); fe25519_square(&t0,&t1); }
-	/* 2^50 - 2^0 */ fe25519_mul(&z2_50_0,&t0,&z2_10_0);
-
-	/* 2^51 - 2^1 */ fe25519_square(&t0,&z2_50_0);
-	/* 2^52 - 2^2 */ fe25519_square(&t1,&t0);
-	/* 2^100 - 2^50 */ for (i = 2;i < 50;i += 2) { fe25519_square(&t0,&t1); fe25519_square(&t1,&t0); }
-	/* 2^100 - 2^0 */ fe25519_mul(&z2_100_0,&t1,&z2_50_0);
-
-	/* 2^101 - 2^1 */ fe25519_square(&t1,&z2_100_0);
-	/* 2^102 - 2^2 */ fe25519_square(&t0,&t1);
-	/* 2^200 - 2^100 */ for (i = 2;i < 100;i += 2) { fe25519_square(&t1,&t0); fe25519_square(&t0,&t1); }
-	/* 2^200 - 2^0 */ fe25519_mul(&t1,&t0,&z2_100_0);
-
-	/* 2^201 - 2^1 */ fe25519_square(&t0,&t1);
-	/* 2^202 - 2^2 */ fe25519_square(&t1,&t0);
-	/* 2^250 - 2^50 */ for (i = 2;i < 50;i += 2) { fe25519_square(&t0,&t1); fe25519_square(&t1,&t0); }
-	/* 2^250 - 2^0 */ fe25519_mul(&t0,&t1,&z2_50_0);
-
-	/* 2^251 - 2^1 */ fe25519_square(&t1,&t0);
-	/* 2^252 - 2^2 */ fe25519_square(&t0,&t1);
-	/* 2^253 - 2^3 */ fe25519_square(&t1,&t0);
-	/* 2^254 - 2^4 */ fe25519_square(&t0,&t1);
-	/* 2^255 - 2^5 */ fe25519_square(&t1,&t0);
-	/* 2^255 - 21 */ fe25519_mul(r,&t1,&z11);
-}
-
-void fe25519_pow2523(fe25519 *r, const fe25519 *x)
-{
-	fe25519 z2;
-	fe25519 z9;
-	fe25519 z11;
-	fe25519 z2_5_0;
-	fe25519 z2_10_0;
-	fe25519 z2_20_0;
-	fe25519 z2_50_0;
-	fe25519 z2_100_0;
-	fe25519 t;
-	int i;
-
-	/* 2 */ fe25519_square(&z2,x);
-	/* 4 */ fe25519_square(&t,&z2);
-	/* 8 */ fe25519_square(&t,&t);
-	/* 9 */ fe25519_mul(&z9,&t,x);
-	/* 11 */ fe25519_mul(&z11,&z9,&z2);
-	/* 22 */ fe25519_square(&t,&z11);
-	/* 2^5 - 2^0 = 31 */ fe25519_mul(&z2_5_0,&t,&z9);
-
-	/* 2^6 - 2^1 */ fe25519_square(&t,&z2_5_0);
-	/* 2^10 - 2^5 */ for (i = 1;i < 5;i++) { fe25519_square(&t,&t); }
-	/* 2^10 - 2^0 */ fe25519_mul(&z2_10_0,&t,&z2_5_0);
-
-	/* 2^11 - 2^1 */ fe25519_square(&t,&z2_10_0);
-	/* 2^20 - 2^10 */ for (i = 1;i < 10;i++) { fe25519_square(&t,&t); }
-	/* 2^20 - 2^0 */ fe25519_mul(&z2_20_0,&t,&z2_10_0);
-
-	/* 2^21 - 2^1 */ fe25519_square(&t,&z2_20_0);
-	/* 2^40 - 2^20 */ for (i = 1;i < 20;i++) { fe25519_square(&t,&t); }
-	/* 2^40 - 2^0 */ fe25519_mul(&t,&t,&z2_20_0);
-
-	/* 2^41 - 2^1 */ fe25519_square(&t,&t);
-	/* 2^50 - 2^10 */ for (i = 1;i < 10;i++) { fe25519_square(&t,&t); }
-	/* 2^50 - 2^0 */ fe25519_mul(&z2_50_0,&t,&z2_10_0);
-
-	/* 2^51 - 2^1 */ fe25519_square(&t,&z2_50_0);
-	/* 2^100 - 2^50 */ for (i = 1;i < 50;i++) { fe25519_square(&t,&t); }
-	/* 2^100 - 2^0 */ fe25519_mul(&z2_100_0,&t,&z2_50_0);
-
-	/* 2^101 - 2^1 */ fe25519_square(&t,&z2_100_0);
-	/* 2^200 - 2^100 */ for (i = 1;i < 100;i++) { fe25519_square(&t,&t); }
-	/* 2^200 - 2^0 */ fe25519_mul(&t,&t,&z2_100_0);
-
-	/* 2^201 - 2^1 */ fe25519_square(&t,&t);
-	/* 2^250 - 2^50 */ for (i = 1;i < 50;i++) { fe25519_square(&t,&t); }
-	/* 2^250 - 2^0 */ fe25519_mul(&t,&t,&z2_50_0);
-
-	/* 2^251 - 2^1 */ fe25519_square(&t,&t);
-	/* 2^252 - 2^2 */ fe25519_square(&t,&t);
-	/* 2^252 - 3 */ fe25519_mul(r,&t,x);
-}
+#endif
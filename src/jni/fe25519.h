@@ -1,6 +1,37 @@
 #ifndef FE25519_H
 #define FE25519_H
 
+#include "avrnacl.h"
+
+/* Field backend selection. The original avrnacl code stores field elements
+ * as 32 bytes and is meant for 8-bit microcontrollers. Targets with a 64x64->128
+ * bit multiplier use 5 limbs of 51 bits instead (fe25519_radix51.c), all
+ * other targets use 10 limbs of 25.5 bits with 32x32->64 bit multiplications
+ * (fe25519_radix25.c). Define FE25519_RADIX8 to force the byte-oriented
+ * implementation. */
+#if !defined(FE25519_RADIX8) && !defined(FE25519_RADIX25) && !defined(FE25519_RADIX51)
+  #if defined(__AVR__)
+    #define FE25519_RADIX8
+  #elif defined(__SIZEOF_INT128__)
+    #define FE25519_RADIX51
+  #else
+    #define FE25519_RADIX25
+  #endif
+#endif
+
+/* Inversion: fe25519_invert_chain computes x^(p-2) with the addition chain
+ * of avrnacl (fe25519_pow.c), fe25519_invert_safegcd uses the constant-time
+ * gcd algorithm of Bernstein and Yang (fe25519_modinv.c). fe25519_invert is
+ * one of the two; define FE25519_INVERT_CHAIN or FE25519_INVERT_SAFEGCD to
+ * choose. */
+#if !defined(FE25519_INVERT_CHAIN) && !defined(FE25519_INVERT_SAFEGCD)
+  #if defined(__AVR__)
+    #define FE25519_INVERT_CHAIN
+  #else
+    #define FE25519_INVERT_SAFEGCD
+  #endif
+#endif
+
 #define fe25519_freeze avrnacl_fe25519_freeze
 #define fe25519_unpack avrnacl_fe25519_unpack
 #define fe25519_pack avrnacl_fe25519_pack
@@ -13,17 +44,46 @@
 #define fe25519_getparity avrnacl_fe25519_getparity
 #define fe25519_add avrnacl_fe25519_add
 #define fe25519_sub avrnacl_fe25519_sub
+#if defined(FE25519_RADIX8)
+  #define fe25519_add_nr avrnacl_fe25519_add
+  #define fe25519_sub_nr avrnacl_fe25519_sub
+#else
+  #define fe25519_add_nr avrnacl_fe25519_add_nr
+  #define fe25519_sub_nr avrnacl_fe25519_sub_nr
+#endif
 #define fe25519_mul avrnacl_fe25519_mul
+#define fe25519_mul121666 avrnacl_fe25519_mul121666
 #define fe25519_square avrnacl_fe25519_square
-#define fe25519_invert avrnacl_fe25519_invert
+#define fe25519_invert_chain avrnacl_fe25519_invert_chain
+#define fe25519_invert_safegcd avrnacl_fe25519_invert_safegcd
+#if defined(FE25519_INVERT_SAFEGCD)
+  #define fe25519_invert avrnacl_fe25519_invert_safegcd
+#else
+  #define fe25519_invert avrnacl_fe25519_invert_chain
+#endif
 #define fe25519_pow2523 avrnacl_fe25519_pow2523
+#define fe25519_batch_invert avrnacl_fe25519_batch_invert
 
 
+#if defined(FE25519_RADIX51)
+typedef struct
+{
+  crypto_uint64 v[5];
+}
+fe25519;
+#elif defined(FE25519_RADIX25)
+typedef struct
+{
+  crypto_uint32 v[10];
+}
+fe25519;
+#else
 typedef struct
 {
   unsigned char v[32];
 }
 fe25519;
+#endif
 
 void fe25519_freeze(fe25519 *r);
 
@@ -49,12 +109,32 @@ void fe25519_add(fe25519 *r, const fe25519 *x, const fe25519 *y);
 
 void fe25519_sub(fe25519 *r, const fe25519 *x, const fe25519 *y);
 
+/* Addition and subtraction without carry propagation. The inputs must be
+ * outputs of fe25519_mul, fe25519_square, fe25519_mul121666 or of a
+ * carrying operation, and the result must only be used as input of
+ * fe25519_mul, fe25519_square or fe25519_mul121666, which accept the
+ * larger limbs. The byte-oriented backend has no headroom for this and
+ * uses fe25519_add and fe25519_sub. */
+#if !defined(FE25519_RADIX8)
+void fe25519_add_nr(fe25519 *r, const fe25519 *x, const fe25519 *y);
+
+void fe25519_sub_nr(fe25519 *r, const fe25519 *x, const fe25519 *y);
+#endif
+
 void fe25519_mul(fe25519 *r, const fe25519 *x, const fe25519 *y);
 
+void fe25519_mul121666(fe25519 *r, const fe25519 *x);
+
 void fe25519_square(fe25519 *r, const fe25519 *x);
 
-void fe25519_invert(fe25519 *r, const fe25519 *x);
+void fe25519_invert_chain(fe25519 *r, const fe25519 *x);
+
+void fe25519_invert_safegcd(fe25519 *r, const fe25519 *x);
 
 void fe25519_pow2523(fe25519 *r, const fe25519 *x);
 
+/* r[i] = 1/x[i] for 0 <= i < n with a single inversion; all x[i] must be
+ * non-zero. r may equal x, tmp has room for n elements. */
+void fe25519_batch_invert(fe25519 *r, const fe25519 *x, fe25519 *tmp, unsigned int n);
+
 #endif
@@ -0,0 +1,384 @@
+/**
+ * This file is part of ECDH-Curve25519-Mobile.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+
+/*
+ * Constant-time inversion modulo p = 2^255-19 with the "safegcd" algorithm
+ * of Bernstein and Yang, "Fast constant-time gcd computation and modular
+ * inversion" (2019). The code follows the modinv64/modinv32 modules of
+ * libsecp256k1: the divsteps are applied in batches of 59 (or 30) on the
+ * low bits of f and g only, and the resulting 2x2 transition matrix is
+ * then applied to the full-length f, g and to the Bezout coefficients d, e.
+ * 590 divsteps are enough for any 256-bit input.
+ *
+ * Targets with 128-bit integers use 5 signed limbs of 62 bits, all others
+ * 9 signed limbs of 30 bits (define FE25519_MODINV30 to force the latter).
+ * The input is frozen and converted from its packed form, so this works
+ * with every field backend.
+ */
+
+#include "avrnacl.h"
+#include "fe25519.h"
+
+#if !defined(FE25519_MODINV30) && !defined(__SIZEOF_INT128__)
+  #define FE25519_MODINV30
+#endif
+
+#if !defined(FE25519_MODINV30)
+
+#define LIMBS 5
+#define LIMBBITS 62
+#define M62 ((crypto_uint64)-1 >> 2)
+
+typedef crypto_int64 limb;
+
+typedef struct
+{
+  crypto_int64 u, v, q, r;
+}
+trans2x2;
+
+/* p in signed radix 2^62 */
+static const limb modulus[LIMBS] = {
+  0x3fffffffffffffedLL, 0x3fffffffffffffffLL, 0x3fffffffffffffffLL, 0x3fffffffffffffffLL, 0x7f
+};
+
+/* 1/p mod 2^62 */
+static const crypto_uint64 modulus_inv62 = 0x39435e50d79435e5ULL;
+
+/* 59 divsteps on the low 64 bits of f and g. The matrix is scaled by 2^62
+ * (starting at 8*identity for 59 steps), so that applying it to f, g gives
+ * values divisible by 2^62. zeta = -(delta+1/2). */
+static crypto_int64 divsteps(crypto_int64 zeta, crypto_uint64 f0, crypto_uint64 g0, trans2x2 *t)
+{
+  crypto_uint64 u = 8, v = 0, q = 0, r = 8;
+  volatile crypto_uint64 c1, c2;
+  crypto_uint64 mask1, mask2, f = f0, g = g0, x, y, z;
+  int i;
+
+  for(i=3;i<62;i++)
+  {
+    /* Masks for zeta < 0 and for g odd */
+    c1 = zeta >> 63;
+    mask1 = c1;
+    c2 = g & 1;
+    mask2 = -c2;
+    /* x, y, z = f, u, v, negated if zeta < 0 */
+    x = (f ^ mask1) - mask1;
+    y = (u ^ mask1) - mask1;
+    z = (v ^ mask1) - mask1;
+    /* If g is odd, add x, y, z to g, q, r */
+    g += x & mask2;
+    q += y & mask2;
+    r += z & mask2;
+    /* If zeta < 0 and g was odd: zeta = -zeta-2 and f, u, v += g, q, r
+     * (which swaps the roles of f and g); otherwise zeta = zeta-1 */
+    mask1 &= mask2;
+    zeta = (zeta ^ mask1) - 1;
+    f += g & mask1;
+    u += q & mask1;
+    v += r & mask1;
+    g >>= 1;
+    u <<= 1;
+    v <<= 1;
+  }
+  t->u = (crypto_int64)u;
+  t->v = (crypto_int64)v;
+  t->q = (crypto_int64)q;
+  t->r = (crypto_int64)r;
+  return zeta;
+}
+
+/* [d,e] = t*[d,e]/2^62 mod p, keeping d, e in (-2p,p) */
+static void update_de(limb *d, limb *e, const trans2x2 *t)
+{
+  const crypto_int64 u = t->u, v = t->v, q = t->q, r = t->r;
+  crypto_int64 md, me, sd, se;
+  crypto_int128 cd, ce;
+  int i;
+
+  /* Add multiples of p that make the low 62 bits zero; start with
+   * [u,q] if d is negative and [v,r] if e is negative */
+  sd = d[LIMBS-1] >> 63;
+  se = e[LIMBS-1] >> 63;
+  md = (u & sd) + (v & se);
+  me = (q & sd) + (r & se);
+  cd = (crypto_int128)u * d[0] + (crypto_int128)v * e[0];
+  ce = (crypto_int128)q * d[0] + (crypto_int128)r * e[0];
+  md -= (modulus_inv62 * (crypto_uint64)cd + md) & M62;
+  me -= (modulus_inv62 * (crypto_uint64)ce + me) & M62;
+  cd += (crypto_int128)modulus[0] * md;
+  ce += (crypto_int128)modulus[0] * me;
+  cd >>= 62;
+  ce >>= 62;
+  for(i=1;i<LIMBS;i++)
+  {
+    cd += (crypto_int128)u * d[i] + (crypto_int128)v * e[i] + (crypto_int128)modulus[i] * md;
+    ce += (crypto_int128)q * d[i] + (crypto_int128)r * e[i] + (crypto_int128)modulus[i] * me;
+    d[i-1] = (crypto_int64)cd & M62; cd >>= 62;
+    e[i-1] = (crypto_int64)ce & M62; ce >>= 62;
+  }
+  d[LIMBS-1] = (crypto_int64)cd;
+  e[LIMBS-1] = (crypto_int64)ce;
+}
+
+/* [f,g] = t*[f,g]/2^62 */
+static void update_fg(limb *f, limb *g, const trans2x2 *t)
+{
+  const crypto_int64 u = t->u, v = t->v, q = t->q, r = t->r;
+  crypto_int128 cf, cg;
+  int i;
+
+  cf = (crypto_int128)u * f[0] + (crypto_int128)v * g[0];
+  cg = (crypto_int128)q * f[0] + (crypto_int128)r * g[0];
+  cf >>= 62;
+  cg >>= 62;
+  for(i=1;i<LIMBS;i++)
+  {
+    cf += (crypto_int128)u * f[i] + (crypto_int128)v * g[i];
+    cg += (crypto_int128)q * f[i] + (crypto_int128)r * g[i];
+    f[i-1] = (crypto_int64)cf & M62; cf >>= 62;
+    g[i-1] = (crypto_int64)cg & M62; cg >>= 62;
+  }
+  f[LIMBS-1] = (crypto_int64)cf;
+  g[LIMBS-1] = (crypto_int64)cg;
+}
+
+#define ITERATIONS 10
+
+#else
+
+#define LIMBS 9
+#define LIMBBITS 30
+#define M30 ((crypto_uint32)-1 >> 2)
+
+typedef crypto_int32 limb;
+
+typedef struct
+{
+  crypto_int32 u, v, q, r;
+}
+trans2x2;
+
+/* p in signed radix 2^30 */
+static const limb modulus[LIMBS] = {
+  0x3fffffed, 0x3fffffff, 0x3fffffff, 0x3fffffff, 0x3fffffff, 0x3fffffff, 0x3fffffff, 0x3fffffff, 0x7fff
+};
+
+/* 1/p mod 2^30 */
+static const crypto_uint32 modulus_inv30 = 0x179435e5UL;
+
+/* 30 divsteps on the low 32 bits of f and g; the matrix is scaled by 2^30 */
+static crypto_int32 divsteps(crypto_int32 zeta, crypto_uint32 f0, crypto_uint32 g0, trans2x2 *t)
+{
+  crypto_uint32 u = 1, v = 0, q = 0, r = 1;
+  volatile crypto_uint32 c1, c2;
+  crypto_uint32 mask1, mask2, f = f0, g = g0, x, y, z;
+  int i;
+
+  for(i=0;i<30;i++)
+  {
+    c1 = zeta >> 31;
+    mask1 = c1;
+    c2 = g & 1;
+    mask2 = -c2;
+    x = (f ^ mask1) - mask1;
+    y = (u ^ mask1) - mask1;
+    z = (v ^ mask1) - mask1;
+    g += x & mask2;
+    q += y & mask2;
+    r += z & mask2;
+    mask1 &= mask2;
+    zeta = (zeta ^ mask1) - 1;
+    f += g & mask1;
+    u += q & mask1;
+    v += r & mask1;
+    g >>= 1;
+    u <<= 1;
+    v <<= 1;
+  }
+  t->u = (crypto_int32)u;
+  t->v = (crypto_int32)v;
+  t->q = (crypto_int32)q;
+  t->r = (crypto_int32)r;
+  return zeta;
+}
+
+/* [d,e] = t*[d,e]/2^30 mod p, keeping d, e in (-2p,p) */
+static void update_de(limb *d, limb *e, const trans2x2 *t)
+{
+  const crypto_int32 u = t->u, v = t->v, q = t->q, r = t->r;
+  crypto_int32 md, me, sd, se;
+  crypto_int64 cd, ce;
+  int i;
+
+  sd = d[LIMBS-1] >> 31;
+  se = e[LIMBS-1] >> 31;
+  md = (u & sd) + (v & se);
+  me = (q & sd) + (r & se);
+  cd = (crypto_int64)u * d[0] + (crypto_int64)v * e[0];
+  ce = (crypto_int64)q * d[0] + (crypto_int64)r * e[0];
+  md -= (modulus_inv30 * (crypto_uint32)cd + md) & M30;
+  me -= (modulus_inv30 * (crypto_uint32)ce + me) & M30;
+  cd += (crypto_int64)modulus[0] * md;
+  ce += (crypto_int64)modulus[0] * me;
+  cd >>= 30;
+  ce >>= 30;
+  for(i=1;i<LIMBS;i++)
+  {
+    cd += (crypto_int64)u * d[i] + (crypto_int64)v * e[i] + (crypto_int64)modulus[i] * md;
+    ce += (crypto_int64)q * d[i] + (crypto_int64)r * e[i] + (crypto_int64)modulus[i] * me;
+    d[i-1] = (crypto_int32)cd & M30; cd >>= 30;
+    e[i-1] = (crypto_int32)ce & M30; ce >>= 30;
+  }
+  d[LIMBS-1] = (crypto_int32)cd;
+  e[LIMBS-1] = (crypto_int32)ce;
+}
+
+/* [f,g] = t*[f,g]/2^30 */
+static void update_fg(limb *f, limb *g, const trans2x2 *t)
+{
+  const crypto_int32 u = t->u, v = t->v, q = t->q, r = t->r;
+  crypto_int64 cf, cg;
+  int i;
+
+  cf = (crypto_int64)u * f[0] + (crypto_int64)v * g[0];
+  cg = (crypto_int64)q * f[0] + (crypto_int64)r * g[0];
+  cf >>= 30;
+  cg >>= 30;
+  for(i=1;i<LIMBS;i++)
+  {
+    cf += (crypto_int64)u * f[i] + (crypto_int64)v * g[i];
+    cg += (crypto_int64)q * f[i] + (crypto_int64)r * g[i];
+    f[i-1] = (crypto_int32)cf & M30; cf >>= 30;
+    g[i-1] = (crypto_int32)cg & M30; cg >>= 30;
+  }
+  f[LIMBS-1] = (crypto_int32)cf;
+  g[LIMBS-1] = (crypto_int32)cg;
+}
+
+#define ITERATIONS 20
+
+#endif
+
+#define LIMBMASK (((limb)1 << LIMBBITS) - 1)
+
+static crypto_uint64 load64(const unsigned char *x)
+{
+  crypto_uint64 r = 0;
+  int i;
+  for(i=7;i>=0;i--)
+    r = (r << 8) | x[i];
+  return r;
+}
+
+static void store64(unsigned char *r, crypto_uint64 x)
+{
+  int i;
+  for(i=0;i<8;i++)
+  {
+    r[i] = x & 0xff;
+    x >>= 8;
+  }
+}
+
+/* Bring r from (-2p,p) to [0,p), negating it first if sign < 0 */
+static void normalize(limb *r, limb sign)
+{
+  volatile limb cond_add, cond_negate;
+  int i;
+
+  cond_add = r[LIMBS-1] >> (8*sizeof(limb)-1);
+  for(i=0;i<LIMBS;i++)
+    r[i] += modulus[i] & cond_add;
+  cond_negate = sign >> (8*sizeof(limb)-1);
+  for(i=0;i<LIMBS;i++)
+    r[i] = (r[i] ^ cond_negate) - cond_negate;
+  for(i=0;i<LIMBS-1;i++)
+  {
+    r[i+1] += r[i] >> LIMBBITS;
+    r[i] &= LIMBMASK;
+  }
+
+  cond_add = r[LIMBS-1] >> (8*sizeof(limb)-1);
+  for(i=0;i<LIMBS;i++)
+    r[i] += modulus[i] & cond_add;
+  for(i=0;i<LIMBS-1;i++)
+  {
+    r[i+1] += r[i] >> LIMBBITS;
+    r[i] &= LIMBMASK;
+  }
+}
+
+void fe25519_invert_safegcd(fe25519 *r, const fe25519 *x)
+{
+  unsigned char b[32];
+  crypto_uint64 w[5];
+  limb d[LIMBS], e[LIMBS], f[LIMBS], g[LIMBS];
+  limb zeta = -1;
+  trans2x2 t;
+  int i,off;
+
+  /* g = x in [0,p), f = p, d = 0, e = 1 */
+  fe25519_pack(b, x);
+  for(i=0;i<4;i++)
+    w[i] = load64(b + 8*i);
+  w[4] = 0;
+  for(i=0;i<LIMBS;i++)
+  {
+    /* Bits i*LIMBBITS,... of w; the double shift avoids a shift by 64 */
+    off = (i*LIMBBITS) & 63;
+    g[i] = (limb)(((w[(i*LIMBBITS) >> 6] >> off) | ((w[((i*LIMBBITS) >> 6) + 1] << 1) << (63 - off))) & LIMBMASK);
+    f[i] = modulus[i];
+    d[i] = 0;
+    e[i] = 0;
+  }
+  e[0] = 1;
+
+  for(i=0;i<ITERATIONS;i++)
+  {
+    zeta = divsteps(zeta, f[0], g[0], &t);
+    update_de(d, e, &t);
+    update_fg(f, g, &t);
+  }
+
+  /* Now g = 0 and f = +-1 (f = +-p for x = 0, where d = 0), so d = +-1/x */
+  normalize(d, f[LIMBS-1]);
+
+  for(i=0;i<5;i++)
+    w[i] = 0;
+  for(i=0;i<LIMBS;i++)
+  {
+    off = (i*LIMBBITS) & 63;
+    w[(i*LIMBBITS) >> 6] |= (crypto_uint64)d[i] << off;
+    w[((i*LIMBBITS) >> 6) + 1] |= ((crypto_uint64)d[i] >> 1) >> (63 - off);
+  }
+  for(i=0;i<4;i++)
+    store64(b + 8*i, w[i]);
+  fe25519_unpack(r, b);
+}
@@ -0,0 +1,332 @@
+/**
+ * This file is part of ECDH-Curve25519-Mobile.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+
+/*
+ * Arithmetic in GF(2^255-19) for 32-bit targets. A field element is stored
+ * as 10 unsigned limbs in radix 2^25.5, i.e., limbs alternate between 26 and
+ * 25 bits,
+ * x = v[0] + v[1]*2^26 + v[2]*2^51 + v[3]*2^77 + ... + v[9]*2^230.
+ * Products are accumulated in 64-bit integers using 32x32->64 bit
+ * multiplications. Limbs are only weakly reduced: outputs of all arithmetic
+ * functions have limbs below 2^26, full reduction happens in fe25519_freeze.
+ */
+
+#include "avrnacl.h"
+#include "fe25519.h"
+
+#if defined(FE25519_RADIX25)
+
+#define MASK25 0x1ffffffUL
+#define MASK26 0x3ffffffUL
+
+/******************************************************************/
+/*                Static constants and functions                  */
+/******************************************************************/
+
+static crypto_uint32 load32(const unsigned char *x)
+{
+  return (crypto_uint32)x[0] | ((crypto_uint32)x[1] << 8) | ((crypto_uint32)x[2] << 16) | ((crypto_uint32)x[3] << 24);
+}
+
+/* Propagate carries once through all limbs, folding the top carry back
+ * into v[0] using 2^255 = 19 */
+static void carry(crypto_uint32 *v)
+{
+  crypto_uint32 c;
+  c = v[0] >> 26; v[0] &= MASK26; v[1] += c;
+  c = v[1] >> 25; v[1] &= MASK25; v[2] += c;
+  c = v[2] >> 26; v[2] &= MASK26; v[3] += c;
+  c = v[3] >> 25; v[3] &= MASK25; v[4] += c;
+  c = v[4] >> 26; v[4] &= MASK26; v[5] += c;
+  c = v[5] >> 25; v[5] &= MASK25; v[6] += c;
+  c = v[6] >> 26; v[6] &= MASK26; v[7] += c;
+  c = v[7] >> 25; v[7] &= MASK25; v[8] += c;
+  c = v[8] >> 26; v[8] &= MASK26; v[9] += c;
+  c = v[9] >> 25; v[9] &= MASK25; v[0] += 19*c;
+}
+
+/* Reduce 64-bit column sums to weakly reduced limbs */
+static void reduce64(fe25519 *r, crypto_uint64 *h)
+{
+  crypto_uint64 c;
+  c = h[0] >> 26; r->v[0] = h[0] & MASK26; h[1] += c;
+  c = h[1] >> 25; r->v[1] = h[1] & MASK25; h[2] += c;
+  c = h[2] >> 26; r->v[2] = h[2] & MASK26; h[3] += c;
+  c = h[3] >> 25; r->v[3] = h[3] & MASK25; h[4] += c;
+  c = h[4] >> 26; r->v[4] = h[4] & MASK26; h[5] += c;
+  c = h[5] >> 25; r->v[5] = h[5] & MASK25; h[6] += c;
+  c = h[6] >> 26; r->v[6] = h[6] & MASK26; h[7] += c;
+  c = h[7] >> 25; r->v[7] = h[7] & MASK25; h[8] += c;
+  c = h[8] >> 26; r->v[8] = h[8] & MASK26; h[9] += c;
+  c = h[9] >> 25; r->v[9] = h[9] & MASK25;
+  c = r->v[0] + 19*c;
+  r->v[0] = c & MASK26;
+  r->v[1] += c >> 26;
+}
+
+/******************************************************************/
+/*                Public constants and functions                  */
+/******************************************************************/
+
+void fe25519_add(fe25519 *r, const fe25519 *x, const fe25519 *y)
+{
+  int i;
+  for(i=0;i<10;i++)
+    r->v[i] = x->v[i] + y->v[i];
+  carry(r->v);
+}
+
+void fe25519_sub(fe25519 *r, const fe25519 *x, const fe25519 *y)
+{
+  int i;
+  /* Add 2p before subtracting to keep all limbs positive */
+  r->v[0] = (x->v[0] + 0x7ffffdaUL) - y->v[0];
+  for(i=1;i<10;i++)
+    r->v[i] = (x->v[i] + ((i & 1) ? 0x3fffffeUL : 0x7fffffeUL)) - y->v[i];
+  carry(r->v);
+}
+
+/* Reduced inputs have limbs below 2^26 (even) and 2^25 (odd) plus a small
+ * carry, so the results of the non-carrying versions stay below 1.5*2^27
+ * and 1.5*2^26. Then 19 times a limb still fits in 32 bits and every
+ * accumulator of fe25519_mul and fe25519_square stays below 2^63. */
+void fe25519_add_nr(fe25519 *r, const fe25519 *x, const fe25519 *y)
+{
+  int i;
+  for(i=0;i<10;i++)
+    r->v[i] = x->v[i] + y->v[i];
+}
+
+void fe25519_sub_nr(fe25519 *r, const fe25519 *x, const fe25519 *y)
+{
+  int i;
+  r->v[0] = (x->v[0] + 0x7ffffdaUL) - y->v[0];
+  for(i=1;i<10;i++)
+    r->v[i] = (x->v[i] + ((i & 1) ? 0x3fffffeUL : 0x7fffffeUL)) - y->v[i];
+}
+
+void fe25519_mul(fe25519 *r, const fe25519 *x, const fe25519 *y)
+{
+  crypto_uint32 x0 = x->v[0], x1 = x->v[1], x2 = x->v[2], x3 = x->v[3], x4 = x->v[4];
+  crypto_uint32 x5 = x->v[5], x6 = x->v[6], x7 = x->v[7], x8 = x->v[8], x9 = x->v[9];
+  crypto_uint32 y0 = y->v[0], y1 = y->v[1], y2 = y->v[2], y3 = y->v[3], y4 = y->v[4];
+  crypto_uint32 y5 = y->v[5], y6 = y->v[6], y7 = y->v[7], y8 = y->v[8], y9 = y->v[9];
+  crypto_uint32 x1_2 = 2*x1, x3_2 = 2*x3, x5_2 = 2*x5, x7_2 = 2*x7, x9_2 = 2*x9;
+  crypto_uint32 y1_19 = 19*y1, y2_19 = 19*y2, y3_19 = 19*y3, y4_19 = 19*y4, y5_19 = 19*y5;
+  crypto_uint32 y6_19 = 19*y6, y7_19 = 19*y7, y8_19 = 19*y8, y9_19 = 19*y9;
+  crypto_uint64 h[10];
+
+  h[0] = (crypto_uint64)x0*y0 + (crypto_uint64)x1_2*y9_19 + (crypto_uint64)x2*y8_19 + (crypto_uint64)x3_2*y7_19 + (crypto_uint64)x4*y6_19
+     + (crypto_uint64)x5_2*y5_19 + (crypto_uint64)x6*y4_19 + (crypto_uint64)x7_2*y3_19 + (crypto_uint64)x8*y2_19 + (crypto_uint64)x9_2*y1_19;
+  h[1] = (crypto_uint64)x0*y1 + (crypto_uint64)x1*y0 + (crypto_uint64)x2*y9_19 + (crypto_uint64)x3*y8_19 + (crypto_uint64)x4*y7_19
+     + (crypto_uint64)x5*y6_19 + (crypto_uint64)x6*y5_19 + (crypto_uint64)x7*y4_19 + (crypto_uint64)x8*y3_19 + (crypto_uint64)x9*y2_19;
+  h[2] = (crypto_uint64)x0*y2 + (crypto_uint64)x1_2*y1 + (crypto_uint64)x2*y0 + (crypto_uint64)x3_2*y9_19 + (crypto_uint64)x4*y8_19
+     + (crypto_uint64)x5_2*y7_19 + (crypto_uint64)x6*y6_19 + (crypto_uint64)x7_2*y5_19 + (crypto_uint64)x8*y4_19 + (crypto_uint64)x9_2*y3_19;
+  h[3] = (crypto_uint64)x0*y3 + (crypto_uint64)x1*y2 + (crypto_uint64)x2*y1 + (crypto_uint64)x3*y0 + (crypto_uint64)x4*y9_19
+     + (crypto_uint64)x5*y8_19 + (crypto_uint64)x6*y7_19 + (crypto_uint64)x7*y6_19 + (crypto_uint64)x8*y5_19 + (crypto_uint64)x9*y4_19;
+  h[4] = (crypto_uint64)x0*y4 + (crypto_uint64)x1_2*y3 + (crypto_uint64)x2*y2 + (crypto_uint64)x3_2*y1 + (crypto_uint64)x4*y0
+     + (crypto_uint64)x5_2*y9_19 + (crypto_uint64)x6*y8_19 + (crypto_uint64)x7_2*y7_19 + (crypto_uint64)x8*y6_19 + (crypto_uint64)x9_2*y5_19;
+  h[5] = (crypto_uint64)x0*y5 + (crypto_uint64)x1*y4 + (crypto_uint64)x2*y3 + (crypto_uint64)x3*y2 + (crypto_uint64)x4*y1
+     + (crypto_uint64)x5*y0 + (crypto_uint64)x6*y9_19 + (crypto_uint64)x7*y8_19 + (crypto_uint64)x8*y7_19 + (crypto_uint64)x9*y6_19;
+  h[6] = (crypto_uint64)x0*y6 + (crypto_uint64)x1_2*y5 + (crypto_uint64)x2*y4 + (crypto_uint64)x3_2*y3 + (crypto_uint64)x4*y2
+     + (crypto_uint64)x5_2*y1 + (crypto_uint64)x6*y0 + (crypto_uint64)x7_2*y9_19 + (crypto_uint64)x8*y8_19 + (crypto_uint64)x9_2*y7_19;
+  h[7] = (crypto_uint64)x0*y7 + (crypto_uint64)x1*y6 + (crypto_uint64)x2*y5 + (crypto_uint64)x3*y4 + (crypto_uint64)x4*y3
+     + (crypto_uint64)x5*y2 + (crypto_uint64)x6*y1 + (crypto_uint64)x7*y0 + (crypto_uint64)x8*y9_19 + (crypto_uint64)x9*y8_19;
+  h[8] = (crypto_uint64)x0*y8 + (crypto_uint64)x1_2*y7 + (crypto_uint64)x2*y6 + (crypto_uint64)x3_2*y5 + (crypto_uint64)x4*y4
+     + (crypto_uint64)x5_2*y3 + (crypto_uint64)x6*y2 + (crypto_uint64)x7_2*y1 + (crypto_uint64)x8*y0 + (crypto_uint64)x9_2*y9_19;
+  h[9] = (crypto_uint64)x0*y9 + (crypto_uint64)x1*y8 + (crypto_uint64)x2*y7 + (crypto_uint64)x3*y6 + (crypto_uint64)x4*y5
+     + (crypto_uint64)x5*y4 + (crypto_uint64)x6*y3 + (crypto_uint64)x7*y2 + (crypto_uint64)x8*y1 + (crypto_uint64)x9*y0;
+
+  reduce64(r,h);
+}
+
+void fe25519_mul121666(fe25519 *r, const fe25519 *x)
+{
+  crypto_uint64 h[10];
+  int i;
+  for(i=0;i<10;i++)
+    h[i] = (crypto_uint64)x->v[i]*121666;
+  reduce64(r,h);
+}
+
+void fe25519_square(fe25519 *r, const fe25519 *x)
+{
+  crypto_uint32 x0 = x->v[0], x1 = x->v[1], x2 = x->v[2], x3 = x->v[3], x4 = x->v[4];
+  crypto_uint32 x5 = x->v[5], x6 = x->v[6], x7 = x->v[7], x8 = x->v[8], x9 = x->v[9];
+  crypto_uint32 x0_2 = 2*x0, x1_2 = 2*x1, x2_2 = 2*x2, x3_2 = 2*x3, x4_2 = 2*x4;
+  crypto_uint32 x5_2 = 2*x5, x6_2 = 2*x6, x7_2 = 2*x7, x8_2 = 2*x8, x9_2 = 2*x9;
+  crypto_uint32 x1_4 = 4*x1, x3_4 = 4*x3, x5_4 = 4*x5, x7_4 = 4*x7;
+  crypto_uint32 x5_19 = 19*x5, x6_19 = 19*x6, x7_19 = 19*x7, x8_19 = 19*x8, x9_19 = 19*x9;
+  crypto_uint64 h[10];
+
+  h[0] = (crypto_uint64)x0*x0 + (crypto_uint64)x1_4*x9_19 + (crypto_uint64)x2_2*x8_19
+     + (crypto_uint64)x3_4*x7_19 + (crypto_uint64)x4_2*x6_19 + (crypto_uint64)x5_2*x5_19;
+  h[1] = (crypto_uint64)x0_2*x1 + (crypto_uint64)x2_2*x9_19 + (crypto_uint64)x3_2*x8_19
+     + (crypto_uint64)x4_2*x7_19 + (crypto_uint64)x5_2*x6_19;
+  h[2] = (crypto_uint64)x0_2*x2 + (crypto_uint64)x1_2*x1 + (crypto_uint64)x3_4*x9_19
+     + (crypto_uint64)x4_2*x8_19 + (crypto_uint64)x5_4*x7_19 + (crypto_uint64)x6*x6_19;
+  h[3] = (crypto_uint64)x0_2*x3 + (crypto_uint64)x1_2*x2 + (crypto_uint64)x4_2*x9_19
+     + (crypto_uint64)x5_2*x8_19 + (crypto_uint64)x6_2*x7_19;
+  h[4] = (crypto_uint64)x0_2*x4 + (crypto_uint64)x1_4*x3 + (crypto_uint64)x2*x2
+     + (crypto_uint64)x5_4*x9_19 + (crypto_uint64)x6_2*x8_19 + (crypto_uint64)x7_2*x7_19;
+  h[5] = (crypto_uint64)x0_2*x5 + (crypto_uint64)x1_2*x4 + (crypto_uint64)x2_2*x3
+     + (crypto_uint64)x6_2*x9_19 + (crypto_uint64)x7_2*x8_19;
+  h[6] = (crypto_uint64)x0_2*x6 + (crypto_uint64)x1_4*x5 + (crypto_uint64)x2_2*x4
+     + (crypto_uint64)x3_2*x3 + (crypto_uint64)x7_4*x9_19 + (crypto_uint64)x8*x8_19;
+  h[7] = (crypto_uint64)x0_2*x7 + (crypto_uint64)x1_2*x6 + (crypto_uint64)x2_2*x5
+     + (crypto_uint64)x3_2*x4 + (crypto_uint64)x8_2*x9_19;
+  h[8] = (crypto_uint64)x0_2*x8 + (crypto_uint64)x1_4*x7 + (crypto_uint64)x2_2*x6
+     + (crypto_uint64)x3_4*x5 + (crypto_uint64)x4*x4 + (crypto_uint64)x9_2*x9_19;
+  h[9] = (crypto_uint64)x0_2*x9 + (crypto_uint64)x1_2*x8 + (crypto_uint64)x2_2*x7
+     + (crypto_uint64)x3_2*x6 + (crypto_uint64)x4_2*x5;
+
+  reduce64(r,h);
+}
+
+void fe25519_setzero(fe25519 *r)
+{
+  int i;
+  for(i=0;i<10;i++)
+    r->v[i]=0;
+}
+
+void fe25519_setone(fe25519 *r)
+{
+  int i;
+  r->v[0] = 1;
+  for(i=1;i<10;i++)
+    r->v[i]=0;
+}
+
+unsigned char fe25519_getparity(const fe25519 *x)
+{
+  fe25519 t = *x;
+  fe25519_freeze(&t);
+  return t.v[0] & 1;
+}
+
+int fe25519_iszero(const fe25519 *x)
+{
+  fe25519 t = *x;
+  crypto_uint32 r = 0;
+  int i;
+  fe25519_freeze(&t);
+  for(i=0;i<10;i++)
+    r |= t.v[i];
+  return (int)(1 & ((r - 1) >> 31));
+}
+
+int fe25519_iseq_vartime(const fe25519 *x, const fe25519 *y)
+{
+  fe25519 t1 = *x;
+  fe25519 t2 = *y;
+  int i;
+  fe25519_freeze(&t1);
+  fe25519_freeze(&t2);
+  for(i=0;i<10;i++)
+    if(t1.v[i] != t2.v[i]) return 0;
+  return 1;
+}
+
+void fe25519_neg(fe25519 *r, const fe25519 *x)
+{
+  fe25519 t;
+  fe25519_setzero(&t);
+  fe25519_sub(r, &t, x);
+}
+
+void fe25519_cmov(fe25519 *r, const fe25519 *x, unsigned char b)
+{
+  crypto_uint32 mask = b;
+  int i;
+  mask = -mask;
+  for(i=0;i<10;i++)
+    r->v[i] ^= mask & (x->v[i] ^ r->v[i]);
+}
+
+void fe25519_unpack(fe25519 *r, const unsigned char x[32])
+{
+  r->v[0] = load32(x) & MASK26;
+  r->v[1] = (load32(x+3) >> 2) & MASK25;
+  r->v[2] = (load32(x+6) >> 3) & MASK26;
+  r->v[3] = (load32(x+9) >> 5) & MASK25;
+  r->v[4] = (load32(x+12) >> 6) & MASK26;
+  r->v[5] = load32(x+16) & MASK25;
+  r->v[6] = (load32(x+19) >> 1) & MASK26;
+  r->v[7] = (load32(x+22) >> 3) & MASK25;
+  r->v[8] = (load32(x+25) >> 4) & MASK26;
+  r->v[9] = (load32(x+28) >> 6) & MASK25;
+}
+
+void fe25519_pack(unsigned char r[32], const fe25519 *x)
+{
+  fe25519 y = *x;
+  crypto_uint64 acc = 0;
+  int bits = 0, i, j = 0;
+  fe25519_freeze(&y);
+  for(i=0;i<10;i++)
+  {
+    acc |= (crypto_uint64)y.v[i] << bits;
+    bits += (i & 1) ? 25 : 26;
+    while(bits >= 8)
+    {
+      r[j++] = acc & 0xff;
+      acc >>= 8;
+      bits -= 8;
+    }
+  }
+  r[j] = acc & 0xff;
+}
+
+/* reduction modulo 2^255-19 */
+void fe25519_freeze(fe25519 *r)
+{
+  crypto_uint32 q;
+  int i;
+
+  /* After two carry passes all limbs are in range and x < 2^255 */
+  carry(r->v);
+  carry(r->v);
+
+  /* q = 1 iff x >= p */
+  q = (r->v[0] + 19) >> 26;
+  for(i=1;i<10;i++)
+    q = (r->v[i] + q) >> ((i & 1) ? 25 : 26);
+
+  r->v[0] += 19*q;
+  for(i=0;i<9;i++)
+  {
+    q = r->v[i] >> ((i & 1) ? 25 : 26);
+    r->v[i] &= (i & 1) ? MASK25 : MASK26;
+    r->v[i+1] += q;
+  }
+  r->v[9] &= MASK25;
+}
+
+#endif
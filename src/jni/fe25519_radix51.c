@@ -0,0 +1,285 @@
+/**
+ * This file is part of ECDH-Curve25519-Mobile.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+
+/*
+ * Arithmetic in GF(2^255-19) for targets with a 64x64->128 bit multiplier.
+ * A field element is stored as 5 unsigned limbs in radix 2^51,
+ * x = v[0] + v[1]*2^51 + v[2]*2^102 + v[3]*2^153 + v[4]*2^204.
+ * Limbs are only weakly reduced: outputs of all arithmetic functions have
+ * limbs below 2^51 + 2^13, full reduction happens in fe25519_freeze.
+ */
+
+#include "avrnacl.h"
+#include "fe25519.h"
+
+#if defined(FE25519_RADIX51)
+
+#define MASK51 0x7ffffffffffffULL
+
+/******************************************************************/
+/*                Static constants and functions                  */
+/******************************************************************/
+
+static crypto_uint64 load64(const unsigned char *x)
+{
+  crypto_uint64 r = 0;
+  int i;
+  for(i=7;i>=0;i--)
+    r = (r << 8) | x[i];
+  return r;
+}
+
+/* Propagate carries once through all limbs, folding the top carry back
+ * into v[0] using 2^255 = 19 */
+static void carry(crypto_uint64 *v)
+{
+  crypto_uint64 c;
+  c = v[0] >> 51; v[0] &= MASK51; v[1] += c;
+  c = v[1] >> 51; v[1] &= MASK51; v[2] += c;
+  c = v[2] >> 51; v[2] &= MASK51; v[3] += c;
+  c = v[3] >> 51; v[3] &= MASK51; v[4] += c;
+  c = v[4] >> 51; v[4] &= MASK51; v[0] += 19*c;
+}
+
+/* Reduce 128-bit column sums to weakly reduced limbs */
+static void reduce128(fe25519 *r, crypto_uint128 t0, crypto_uint128 t1, crypto_uint128 t2, crypto_uint128 t3, crypto_uint128 t4)
+{
+  crypto_uint64 r0,r1,r2,r3,r4,c;
+
+  r0 = (crypto_uint64)t0 & MASK51; t1 += (crypto_uint64)(t0 >> 51);
+  r1 = (crypto_uint64)t1 & MASK51; t2 += (crypto_uint64)(t1 >> 51);
+  r2 = (crypto_uint64)t2 & MASK51; t3 += (crypto_uint64)(t2 >> 51);
+  r3 = (crypto_uint64)t3 & MASK51; t4 += (crypto_uint64)(t3 >> 51);
+  r4 = (crypto_uint64)t4 & MASK51; c = (crypto_uint64)(t4 >> 51);
+  r0 += 19*c;
+  c = r0 >> 51; r0 &= MASK51; r1 += c;
+
+  r->v[0] = r0;
+  r->v[1] = r1;
+  r->v[2] = r2;
+  r->v[3] = r3;
+  r->v[4] = r4;
+}
+
+/******************************************************************/
+/*                Public constants and functions                  */
+/******************************************************************/
+
+void fe25519_add(fe25519 *r, const fe25519 *x, const fe25519 *y)
+{
+  int i;
+  for(i=0;i<5;i++)
+    r->v[i] = x->v[i] + y->v[i];
+  carry(r->v);
+}
+
+void fe25519_sub(fe25519 *r, const fe25519 *x, const fe25519 *y)
+{
+  /* Add 2p before subtracting to keep all limbs positive */
+  r->v[0] = (x->v[0] + 0xfffffffffffdaULL) - y->v[0];
+  r->v[1] = (x->v[1] + 0xffffffffffffeULL) - y->v[1];
+  r->v[2] = (x->v[2] + 0xffffffffffffeULL) - y->v[2];
+  r->v[3] = (x->v[3] + 0xffffffffffffeULL) - y->v[3];
+  r->v[4] = (x->v[4] + 0xffffffffffffeULL) - y->v[4];
+  carry(r->v);
+}
+
+/* Reduced inputs have limbs below 2^51 plus a small carry, so the results
+ * of the non-carrying versions stay below 2^53. fe25519_mul and
+ * fe25519_square take limbs up to 2^54 without overflowing their
+ * 128-bit accumulators. */
+void fe25519_add_nr(fe25519 *r, const fe25519 *x, const fe25519 *y)
+{
+  int i;
+  for(i=0;i<5;i++)
+    r->v[i] = x->v[i] + y->v[i];
+}
+
+void fe25519_sub_nr(fe25519 *r, const fe25519 *x, const fe25519 *y)
+{
+  r->v[0] = (x->v[0] + 0xfffffffffffdaULL) - y->v[0];
+  r->v[1] = (x->v[1] + 0xffffffffffffeULL) - y->v[1];
+  r->v[2] = (x->v[2] + 0xffffffffffffeULL) - y->v[2];
+  r->v[3] = (x->v[3] + 0xffffffffffffeULL) - y->v[3];
+  r->v[4] = (x->v[4] + 0xffffffffffffeULL) - y->v[4];
+}
+
+void fe25519_mul(fe25519 *r, const fe25519 *x, const fe25519 *y)
+{
+  crypto_uint64 x0 = x->v[0], x1 = x->v[1], x2 = x->v[2], x3 = x->v[3], x4 = x->v[4];
+  crypto_uint64 y0 = y->v[0], y1 = y->v[1], y2 = y->v[2], y3 = y->v[3], y4 = y->v[4];
+  crypto_uint64 y1_19 = 19*y1, y2_19 = 19*y2, y3_19 = 19*y3, y4_19 = 19*y4;
+  crypto_uint128 t0,t1,t2,t3,t4;
+
+  t0 = (crypto_uint128)x0*y0 + (crypto_uint128)x1*y4_19 + (crypto_uint128)x2*y3_19 + (crypto_uint128)x3*y2_19 + (crypto_uint128)x4*y1_19;
+  t1 = (crypto_uint128)x0*y1 + (crypto_uint128)x1*y0 + (crypto_uint128)x2*y4_19 + (crypto_uint128)x3*y3_19 + (crypto_uint128)x4*y2_19;
+  t2 = (crypto_uint128)x0*y2 + (crypto_uint128)x1*y1 + (crypto_uint128)x2*y0 + (crypto_uint128)x3*y4_19 + (crypto_uint128)x4*y3_19;
+  t3 = (crypto_uint128)x0*y3 + (crypto_uint128)x1*y2 + (crypto_uint128)x2*y1 + (crypto_uint128)x3*y0 + (crypto_uint128)x4*y4_19;
+  t4 = (crypto_uint128)x0*y4 + (crypto_uint128)x1*y3 + (crypto_uint128)x2*y2 + (crypto_uint128)x3*y1 + (crypto_uint128)x4*y0;
+
+  reduce128(r,t0,t1,t2,t3,t4);
+}
+
+void fe25519_mul121666(fe25519 *r, const fe25519 *x)
+{
+  crypto_uint128 t0,t1,t2,t3,t4;
+
+  t0 = (crypto_uint128)x->v[0]*121666;
+  t1 = (crypto_uint128)x->v[1]*121666;
+  t2 = (crypto_uint128)x->v[2]*121666;
+  t3 = (crypto_uint128)x->v[3]*121666;
+  t4 = (crypto_uint128)x->v[4]*121666;
+
+  reduce128(r,t0,t1,t2,t3,t4);
+}
+
+void fe25519_square(fe25519 *r, const fe25519 *x)
+{
+  crypto_uint64 x0 = x->v[0], x1 = x->v[1], x2 = x->v[2], x3 = x->v[3], x4 = x->v[4];
+  crypto_uint64 x0_2 = 2*x0, x1_2 = 2*x1;
+  crypto_uint64 x3_19 = 19*x3, x4_19 = 19*x4;
+  crypto_uint64 x3_38 = 2*x3_19, x4_38 = 2*x4_19;
+  crypto_uint128 t0,t1,t2,t3,t4;
+
+  t0 = (crypto_uint128)x0*x0   + (crypto_uint128)x1*x4_38 + (crypto_uint128)x2*x3_38;
+  t1 = (crypto_uint128)x0_2*x1 + (crypto_uint128)x2*x4_38 + (crypto_uint128)x3*x3_19;
+  t2 = (crypto_uint128)x0_2*x2 + (crypto_uint128)x1*x1    + (crypto_uint128)x3*x4_38;
+  t3 = (crypto_uint128)x0_2*x3 + (crypto_uint128)x1_2*x2  + (crypto_uint128)x4*x4_19;
+  t4 = (crypto_uint128)x0_2*x4 + (crypto_uint128)x1_2*x3  + (crypto_uint128)x2*x2;
+
+  reduce128(r,t0,t1,t2,t3,t4);
+}
+
+void fe25519_setzero(fe25519 *r)
+{
+  int i;
+  for(i=0;i<5;i++)
+    r->v[i]=0;
+}
+
+void fe25519_setone(fe25519 *r)
+{
+  int i;
+  r->v[0] = 1;
+  for(i=1;i<5;i++)
+    r->v[i]=0;
+}
+
+unsigned char fe25519_getparity(const fe25519 *x)
+{
+  fe25519 t = *x;
+  fe25519_freeze(&t);
+  return t.v[0] & 1;
+}
+
+int fe25519_iszero(const fe25519 *x)
+{
+  fe25519 t = *x;
+  crypto_uint64 r;
+  fe25519_freeze(&t);
+  r = t.v[0] | t.v[1] | t.v[2] | t.v[3] | t.v[4];
+  return (int)(1 & ((r - 1) >> 63));
+}
+
+int fe25519_iseq_vartime(const fe25519 *x, const fe25519 *y)
+{
+  fe25519 t1 = *x;
+  fe25519 t2 = *y;
+  int i;
+  fe25519_freeze(&t1);
+  fe25519_freeze(&t2);
+  for(i=0;i<5;i++)
+    if(t1.v[i] != t2.v[i]) return 0;
+  return 1;
+}
+
+void fe25519_neg(fe25519 *r, const fe25519 *x)
+{
+  fe25519 t;
+  fe25519_setzero(&t);
+  fe25519_sub(r, &t, x);
+}
+
+void fe25519_cmov(fe25519 *r, const fe25519 *x, unsigned char b)
+{
+  crypto_uint64 mask = b;
+  int i;
+  mask = -mask;
+  for(i=0;i<5;i++)
+    r->v[i] ^= mask & (x->v[i] ^ r->v[i]);
+}
+
+void fe25519_unpack(fe25519 *r, const unsigned char x[32])
+{
+  r->v[0] = load64(x) & MASK51;
+  r->v[1] = (load64(x+6) >> 3) & MASK51;
+  r->v[2] = (load64(x+12) >> 6) & MASK51;
+  r->v[3] = (load64(x+19) >> 1) & MASK51;
+  r->v[4] = (load64(x+24) >> 12) & MASK51;
+}
+
+void fe25519_pack(unsigned char r[32], const fe25519 *x)
+{
+  fe25519 y = *x;
+  crypto_uint64 t[4];
+  int i;
+  fe25519_freeze(&y);
+  t[0] = y.v[0] | (y.v[1] << 51);
+  t[1] = (y.v[1] >> 13) | (y.v[2] << 38);
+  t[2] = (y.v[2] >> 26) | (y.v[3] << 25);
+  t[3] = (y.v[3] >> 39) | (y.v[4] << 12);
+  for(i=0;i<32;i++)
+    r[i] = (t[i >> 3] >> (8*(i & 7))) & 0xff;
+}
+
+/* reduction modulo 2^255-19 */
+void fe25519_freeze(fe25519 *r)
+{
+  crypto_uint64 q;
+
+  /* After two carry passes all limbs are below 2^51 and x < 2^255 */
+  carry(r->v);
+  carry(r->v);
+
+  /* q = 1 iff x >= p */
+  q = (r->v[0] + 19) >> 51;
+  q = (r->v[1] + q) >> 51;
+  q = (r->v[2] + q) >> 51;
+  q = (r->v[3] + q) >> 51;
+  q = (r->v[4] + q) >> 51;
+
+  r->v[0] += 19*q;
+  q = r->v[0] >> 51; r->v[0] &= MASK51; r->v[1] += q;
+  q = r->v[1] >> 51; r->v[1] &= MASK51; r->v[2] += q;
+  q = r->v[2] >> 51; r->v[2] &= MASK51; r->v[3] += q;
+  q = r->v[3] >> 51; r->v[3] &= MASK51; r->v[4] += q;
+  r->v[4] &= MASK51;
+}
+
+#endif
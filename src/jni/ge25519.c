@@ -0,0 +1,405 @@
+/**
+ * This file is part of ECDH-Curve25519-Mobile.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+
+/*
+ * Edwards group arithmetic for fixed-base and fixed-point scalar
+ * multiplication. The formulas are those of the ref10 implementation of
+ * Ed25519 (Bernstein, Duif, Lange, Schwabe, Yang), written on top of the
+ * fe25519 interface so that they work with every field backend.
+ *
+ * Scalar multiplication uses signed radix-16 digits s = sum e[i]*16^i with
+ * e[i] in [-8,8] and a table of the multiples j*256^k*P for j = 1,...,8,
+ * k = 0,...,31: s*P = 16*sum_k e[2k+1]*256^k*P + sum_k e[2k]*256^k*P,
+ * i.e., 64 mixed additions and 4 doublings. Table entries are selected by
+ * scanning the whole row with masks.
+ */
+
+#include "avrnacl.h"
+#include "fe25519.h"
+#include "ge25519.h"
+
+/* Completed coordinates: x = X/Z, y = Y/T */
+typedef struct
+{
+  fe25519 x;
+  fe25519 y;
+  fe25519 z;
+  fe25519 t;
+}
+ge25519_p1p1;
+
+/* Projective coordinates: x = X/Z, y = Y/Z */
+typedef struct
+{
+  fe25519 x;
+  fe25519 y;
+  fe25519 z;
+}
+ge25519_p2;
+
+/* Affine: y+x, y-x, 2*d*x*y */
+typedef struct
+{
+  fe25519 ypx;
+  fe25519 ymx;
+  fe25519 xy2d;
+}
+ge25519_niels;
+
+/* Projective: Y+X, Y-X, Z, 2*d*T */
+typedef struct
+{
+  fe25519 ypx;
+  fe25519 ymx;
+  fe25519 z;
+  fe25519 t2d;
+}
+ge25519_cached;
+
+/* d = -121665/121666 */
+static const unsigned char ecd[32] = {
+  0xa3, 0x78, 0x59, 0x13, 0xca, 0x4d, 0xeb, 0x75, 0xab, 0xd8, 0x41, 0x41, 0x4d, 0x0a, 0x70, 0x00,
+  0x98, 0xe8, 0x79, 0x77, 0x79, 0x40, 0xc7, 0x8c, 0x73, 0xfe, 0x6f, 0x2b, 0xee, 0x6c, 0x03, 0x52};
+
+/* 2*d */
+static const unsigned char ec2d[32] = {
+  0x59, 0xf1, 0xb2, 0x26, 0x94, 0x9b, 0xd6, 0xeb, 0x56, 0xb1, 0x83, 0x82, 0x9a, 0x14, 0xe0, 0x00,
+  0x30, 0xd1, 0xf3, 0xee, 0xf2, 0x80, 0x8e, 0x19, 0xe7, 0xfc, 0xdf, 0x56, 0xdc, 0xd9, 0x06, 0x24};
+
+/* sqrt(-1) */
+static const unsigned char sqrtm1[32] = {
+  0xb0, 0xa0, 0x0e, 0x4a, 0x27, 0x1b, 0xee, 0xc4, 0x78, 0xe4, 0x2f, 0xad, 0x06, 0x18, 0x43, 0x2f,
+  0xa7, 0xd7, 0xfb, 0x3d, 0x99, 0x00, 0x4d, 0x2b, 0x0b, 0xdf, 0xc1, 0x4f, 0x80, 0x24, 0x83, 0x2b};
+
+static unsigned char equal(unsigned char a, unsigned char b)
+{
+  crypto_uint32 x = a ^ b; /* 0: yes; 1..255: no */
+  x -= 1; /* 4294967295: yes; 0..254: no */
+  x >>= 31; /* 1: yes; 0: no */
+  return x;
+}
+
+static unsigned char negative(signed char b)
+{
+  crypto_uint32 x = b; /* 4294967168..4294967295: yes; 0..127: no */
+  x >>= 31; /* 1: yes; 0: no */
+  return x;
+}
+
+static void p3_0(ge25519_p3 *r)
+{
+  fe25519_setzero(&r->x);
+  fe25519_setone(&r->y);
+  fe25519_setone(&r->z);
+  fe25519_setzero(&r->t);
+}
+
+static void p1p1_to_p2(ge25519_p2 *r, const ge25519_p1p1 *p)
+{
+  fe25519_mul(&r->x, &p->x, &p->t);
+  fe25519_mul(&r->y, &p->y, &p->z);
+  fe25519_mul(&r->z, &p->z, &p->t);
+}
+
+static void p1p1_to_p3(ge25519_p3 *r, const ge25519_p1p1 *p)
+{
+  fe25519_mul(&r->x, &p->x, &p->t);
+  fe25519_mul(&r->y, &p->y, &p->z);
+  fe25519_mul(&r->z, &p->z, &p->t);
+  fe25519_mul(&r->t, &p->x, &p->y);
+}
+
+static void p3_to_cached(ge25519_cached *r, const ge25519_p3 *p)
+{
+  fe25519 d2;
+  fe25519_unpack(&d2, ec2d);
+  fe25519_add(&r->ypx, &p->y, &p->x);
+  fe25519_sub(&r->ymx, &p->y, &p->x);
+  r->z = p->z;
+  fe25519_mul(&r->t2d, &p->t, &d2);
+}
+
+static void p2_dbl(ge25519_p1p1 *r, const ge25519_p2 *p)
+{
+  fe25519 t0;
+  fe25519_square(&r->x, &p->x);
+  fe25519_square(&r->z, &p->y);
+  fe25519_square(&r->t, &p->z);
+  fe25519_add(&r->t, &r->t, &r->t);
+  fe25519_add(&r->y, &p->x, &p->y);
+  fe25519_square(&t0, &r->y);
+  fe25519_add(&r->y, &r->z, &r->x);
+  fe25519_sub(&r->z, &r->z, &r->x);
+  fe25519_sub(&r->x, &t0, &r->y);
+  fe25519_sub(&r->t, &r->t, &r->z);
+}
+
+static void p3_dbl(ge25519_p1p1 *r, const ge25519_p3 *p)
+{
+  ge25519_p2 q;
+  q.x = p->x;
+  q.y = p->y;
+  q.z = p->z;
+  p2_dbl(r, &q);
+}
+
+/* r = p + q */
+static void add(ge25519_p1p1 *r, const ge25519_p3 *p, const ge25519_cached *q)
+{
+  fe25519 t0;
+  fe25519_add(&r->x, &p->y, &p->x);
+  fe25519_sub(&r->y, &p->y, &p->x);
+  fe25519_mul(&r->z, &r->x, &q->ypx);
+  fe25519_mul(&r->y, &r->y, &q->ymx);
+  fe25519_mul(&r->t, &q->t2d, &p->t);
+  fe25519_mul(&r->x, &p->z, &q->z);
+  fe25519_add(&t0, &r->x, &r->x);
+  fe25519_sub(&r->x, &r->z, &r->y);
+  fe25519_add(&r->y, &r->z, &r->y);
+  fe25519_add(&r->z, &t0, &r->t);
+  fe25519_sub(&r->t, &t0, &r->t);
+}
+
+/* r = p + q for affine q */
+static void madd(ge25519_p1p1 *r, const ge25519_p3 *p, const ge25519_niels *q)
+{
+  fe25519 t0;
+  fe25519_add(&r->x, &p->y, &p->x);
+  fe25519_sub(&r->y, &p->y, &p->x);
+  fe25519_mul(&r->z, &r->x, &q->ypx);
+  fe25519_mul(&r->y, &r->y, &q->ymx);
+  fe25519_mul(&r->t, &q->xy2d, &p->t);
+  fe25519_add(&t0, &p->z, &p->z);
+  fe25519_sub(&r->x, &r->z, &r->y);
+  fe25519_add(&r->y, &r->z, &r->y);
+  fe25519_add(&r->z, &t0, &r->t);
+  fe25519_sub(&r->t, &t0, &r->t);
+}
+
+/* t = b*256^pos*P for b in [-8,8], where row holds the multiples of
+ * 256^pos*P */
+static void table_select(ge25519_niels *t, const unsigned char row[8][96], signed char b)
+{
+  unsigned char bnegative = negative(b);
+  unsigned char mask = -bnegative;
+  unsigned char babs = ((unsigned char)b ^ mask) + bnegative;
+  unsigned char buf[96];
+  fe25519 u;
+  int i,j;
+
+  /* The neutral element: y+x = 1, y-x = 1, 2*d*x*y = 0 */
+  for(i=0;i<96;i++) buf[i] = 0;
+  buf[0] = 1;
+  buf[32] = 1;
+
+  for(j=0;j<8;j++)
+  {
+    mask = -equal(babs, j+1);
+    for(i=0;i<96;i++)
+      buf[i] ^= mask & (buf[i] ^ row[j][i]);
+  }
+
+  /* -(x,y) = (-x,y): swap y+x and y-x, negate 2*d*x*y */
+  fe25519_unpack(&t->ypx, buf);
+  fe25519_unpack(&t->ymx, buf+32);
+  fe25519_unpack(&t->xy2d, buf+64);
+  u = t->ypx;
+  fe25519_cmov(&t->ypx, &t->ymx, bnegative);
+  fe25519_cmov(&t->ymx, &u, bnegative);
+  fe25519_neg(&u, &t->xy2d);
+  fe25519_cmov(&t->xy2d, &u, bnegative);
+}
+
+int ge25519_frombytes_vartime(ge25519_p3 *r, const unsigned char p[32])
+{
+  fe25519 u, v, v3, vxx, check, d;
+
+  fe25519_unpack(&r->y, p);
+  fe25519_setone(&r->z);
+  fe25519_unpack(&d, ecd);
+
+  /* x^2 = u/v with u = y^2-1, v = d*y^2+1 */
+  fe25519_square(&u, &r->y);
+  fe25519_mul(&v, &u, &d);
+  fe25519_sub(&u, &u, &r->z);
+  fe25519_add(&v, &v, &r->z);
+
+  /* x = u*v^3*(u*v^7)^((p-5)/8) */
+  fe25519_square(&v3, &v);
+  fe25519_mul(&v3, &v3, &v);
+  fe25519_square(&r->x, &v3);
+  fe25519_mul(&r->x, &r->x, &v);
+  fe25519_mul(&r->x, &r->x, &u);
+  fe25519_pow2523(&r->x, &r->x);
+  fe25519_mul(&r->x, &r->x, &v3);
+  fe25519_mul(&r->x, &r->x, &u);
+
+  fe25519_square(&vxx, &r->x);
+  fe25519_mul(&vxx, &vxx, &v);
+  fe25519_sub(&check, &vxx, &u);
+  if(!fe25519_iszero(&check))
+  {
+    fe25519_add(&check, &vxx, &u);
+    if(!fe25519_iszero(&check)) return -1;
+    fe25519_unpack(&d, sqrtm1);
+    fe25519_mul(&r->x, &r->x, &d);
+  }
+
+  if(fe25519_getparity(&r->x) != (p[31] >> 7))
+    fe25519_neg(&r->x, &r->x);
+
+  fe25519_mul(&r->t, &r->x, &r->y);
+  return 0;
+}
+
+void ge25519_pack_montgomery(unsigned char u[32], const ge25519_p3 *p)
+{
+  fe25519 n, d;
+  fe25519_add(&n, &p->z, &p->y);
+  fe25519_sub(&d, &p->z, &p->y);
+  fe25519_invert(&d, &d);
+  fe25519_mul(&n, &n, &d);
+  fe25519_pack(u, &n);
+}
+
+/* Points converted to affine coordinates with one inversion */
+#define TABLE_CHUNK 64
+
+void ge25519_table_build(ge25519_table *t, const ge25519_p3 *p)
+{
+  fe25519 z[TABLE_CHUNK], tmp[TABLE_CHUNK];
+  fe25519 x, y, d2;
+  ge25519_p3 q, r;
+  ge25519_cached c;
+  ge25519_p1p1 s;
+  ge25519_p2 w;
+  unsigned char *e;
+  int i,j,k;
+
+  /* Projective multiples first; X, Y, Z are kept in the slots of the
+   * final y+x, y-x, 2*d*x*y */
+  q = *p;
+  for(i=0;i<32;i++)
+  {
+    p3_to_cached(&c, &q);
+    r = q;
+    for(j=0;j<8;j++)
+    {
+      e = t->v[i][j];
+      fe25519_pack(e, &r.x);
+      fe25519_pack(e+32, &r.y);
+      fe25519_pack(e+64, &r.z);
+      if(j < 7)
+      {
+        add(&s, &r, &c);
+        p1p1_to_p3(&r, &s);
+      }
+    }
+    /* The next row starts at 256^(i+1)*P = 32*(8*256^i*P) */
+    fe25519_unpack(&w.x, t->v[i][7]);
+    fe25519_unpack(&w.y, t->v[i][7]+32);
+    fe25519_unpack(&w.z, t->v[i][7]+64);
+    for(k=0;k<4;k++)
+    {
+      p2_dbl(&s, &w);
+      p1p1_to_p2(&w, &s);
+    }
+    p2_dbl(&s, &w);
+    p1p1_to_p3(&q, &s);
+  }
+
+  fe25519_unpack(&d2, ec2d);
+  for(k=0;k<32*8;k+=TABLE_CHUNK)
+  {
+    for(i=0;i<TABLE_CHUNK;i++)
+      fe25519_unpack(&z[i], t->v[(k+i)/8][(k+i)%8]+64);
+    fe25519_batch_invert(z, z, tmp, TABLE_CHUNK);
+    for(i=0;i<TABLE_CHUNK;i++)
+    {
+      e = t->v[(k+i)/8][(k+i)%8];
+      fe25519_unpack(&x, e);
+      fe25519_unpack(&y, e+32);
+      fe25519_mul(&x, &x, &z[i]);
+      fe25519_mul(&y, &y, &z[i]);
+      fe25519_add(&r.x, &y, &x);
+      fe25519_pack(e, &r.x);
+      fe25519_sub(&r.x, &y, &x);
+      fe25519_pack(e+32, &r.x);
+      fe25519_mul(&r.x, &x, &y);
+      fe25519_mul(&r.x, &r.x, &d2);
+      fe25519_pack(e+64, &r.x);
+    }
+  }
+}
+
+void ge25519_scalarmult_table(ge25519_p3 *r, const ge25519_table *t, const unsigned char s[32])
+{
+  signed char e[64];
+  signed char carry;
+  ge25519_p1p1 u;
+  ge25519_p2 w;
+  ge25519_niels n;
+  int i;
+
+  for(i=0;i<32;i++)
+  {
+    e[2*i+0] = (s[i] >> 0) & 15;
+    e[2*i+1] = (s[i] >> 4) & 15;
+  }
+  /* e[0],...,e[62] in [-8,7], e[63] in [-8,8] */
+  carry = 0;
+  for(i=0;i<63;i++)
+  {
+    e[i] += carry;
+    carry = e[i] + 8;
+    carry >>= 4;
+    e[i] -= carry << 4;
+  }
+  e[63] += carry;
+
+  p3_0(r);
+  for(i=1;i<64;i+=2)
+  {
+    table_select(&n, t->v[i/2], e[i]);
+    madd(&u, r, &n);
+    p1p1_to_p3(r, &u);
+  }
+
+  p3_dbl(&u, r); p1p1_to_p2(&w, &u);
+  p2_dbl(&u, &w); p1p1_to_p2(&w, &u);
+  p2_dbl(&u, &w); p1p1_to_p2(&w, &u);
+  p2_dbl(&u, &w); p1p1_to_p3(r, &u);
+
+  for(i=0;i<64;i+=2)
+  {
+    table_select(&n, t->v[i/2], e[i]);
+    madd(&u, r, &n);
+    p1p1_to_p3(r, &u);
+  }
+}
@@ -0,0 +1,53 @@
+#ifndef GE25519_H
+#define GE25519_H
+
+/* Group arithmetic on the twisted Edwards curve -x^2 + y^2 = 1 + d x^2 y^2
+ * (ge25519.c), which is birationally equivalent to Curve25519 via
+ * u = (1+y)/(1-y). Point representations and formulas follow the ref10
+ * implementation of Ed25519. */
+
+#include "fe25519.h"
+
+#define ge25519_frombytes_vartime avrnacl_ge25519_frombytes_vartime
+#define ge25519_pack_montgomery avrnacl_ge25519_pack_montgomery
+#define ge25519_table_build avrnacl_ge25519_table_build
+#define ge25519_scalarmult_table avrnacl_ge25519_scalarmult_table
+#define ge25519_scalarmult_base avrnacl_ge25519_scalarmult_base
+
+/* Extended coordinates: x = X/Z, y = Y/Z, x*y = T/Z */
+typedef struct
+{
+  fe25519 x;
+  fe25519 y;
+  fe25519 z;
+  fe25519 t;
+}
+ge25519_p3;
+
+/* A table for ge25519_scalarmult_table: entry v[i][j] is (j+1)*256^i*P in
+ * affine coordinates, stored as the packed field elements y+x, y-x and
+ * 2*d*x*y. */
+typedef struct
+{
+  unsigned char v[32][8][96];
+}
+ge25519_table;
+
+/* Decode the Edwards point with y-coordinate and sign of x as in Ed25519.
+ * Returns 0 on success, -1 if p does not encode a point on the curve. */
+int ge25519_frombytes_vartime(ge25519_p3 *r, const unsigned char p[32]);
+
+/* Montgomery u-coordinate (1+y)/(1-y) of p; 0 for the neutral element */
+void ge25519_pack_montgomery(unsigned char u[32], const ge25519_p3 *p);
+
+/* Fill t with the multiples of p needed by ge25519_scalarmult_table */
+void ge25519_table_build(ge25519_table *t, const ge25519_p3 *p);
+
+/* r = s*P, where t was built from P. s must be below 2^255.
+ * Runs in constant time with respect to s. */
+void ge25519_scalarmult_table(ge25519_p3 *r, const ge25519_table *t, const unsigned char s[32]);
+
+/* r = s*B for the base point B (u = 9), s below 2^255 */
+void ge25519_scalarmult_base(ge25519_p3 *r, const unsigned char s[32]);
+
+#endif
@@ -0,0 +1,78 @@
+/**
+ * This file is part of ECDH-Curve25519-Mobile.
+ *
+ * This is free and unencumbered software released into the public domain.
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ * 
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ * 
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+
+/*
+ * Generates ge25519_base.data, the table of multiples of the base point
+ * used by ge25519_scalarmult_base. Build and run on the host:
+ *
+ *   cc -O2 -o ge25519_base_gen ge25519_base_gen.c ge25519.c fe25519*.c bigint.c
+ *   ./ge25519_base_gen > ge25519_base.data
+ *
+ * The output does not depend on the field backend.
+ */
+
+#include <stdio.h>
+
+#include "avrnacl.h"
+#include "ge25519.h"
+
+/* The base point in Ed25519 encoding: y = 4/5, x even */
+static const unsigned char base[32] = {
+  0x58, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66,
+  0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66};
+
+static ge25519_table t;
+
+int main(void)
+{
+  ge25519_p3 b;
+  int i,j,k;
+
+  if(ge25519_frombytes_vartime(&b, base) != 0)
+    return 1;
+  ge25519_table_build(&t, &b);
+
+  printf("/* Generated by ge25519_base_gen.c: [i][j] = (j+1)*256^i*B as y+x, y-x, 2*d*x*y */\n");
+  for(i=0;i<32;i++)
+  {
+    printf("{\n");
+    for(j=0;j<8;j++)
+    {
+      printf("  {");
+      for(k=0;k<96;k++)
+      {
+        if(k % 16 == 0) printf("\n   ");
+        printf(" 0x%02x%s", t.v[i][j][k], (k < 95) ? "," : "");
+      }
+      printf("\n  }%s\n", (j < 7) ? "," : "");
+    }
+    printf("}%s\n", (i < 31) ? "," : "");
+  }
+  return 0;
+}
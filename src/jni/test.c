@@ -1,4 +1,17 @@
+// Example of a Diffie-Hellman key exchange, followed by known-answer tests
+// of the native code. Exits with status 1 if a test fails. On a host:
+//
+//   cc -O2 -pthread -o test test.c bigint.c curve25519*.c ecdh_curve25519.c fe25519*.c ge25519.c ge25519_base.c
+//   ./test
+//
+// Add -DFE25519_RADIX25 or -DFE25519_RADIX8 to test the other field backends.
+
 #include "ecdh_curve25519.h"
+#include "avrnacl.h"
+#include "curve25519_avx2.h"
+#include "curve25519_dispatch.h"
+#include "curve25519_precomp.h"
+#include "fe25519.h"
 #include <stdio.h>
 #include <string.h>
 #include <stdlib.h>
@@ -32,6 +45,374 @@ void create_random_number(uint8_t *random_number, size_t len)
      }
 }
 
+static int failures = 0;
+
+void hexstr_to_binary(uint8_t *binary, const char *str, unsigned int len)
+{
+     for (unsigned int i = 0; i < len; i++) {
+	  unsigned int byte;
+	  sscanf(str + 2*i, "%2x", &byte);
+	  binary[i] = (uint8_t) byte;
+     }
+}
+
+// Compare the 32-byte value with the expected value given as hex string.
+void check(const char *what, const char *implementation, const uint8_t *value,
+	   const char *expected_hexstr)
+{
+     uint8_t expected[ECDH_CURVE25519_KEY_LENGTH];
+     hexstr_to_binary(expected, expected_hexstr, sizeof(expected));
+     if (memcmp(value, expected, sizeof(expected)) != 0) {
+	  char value_str[ECDH_CURVE25519_KEY_LENGTH*2 + 1];
+	  binary_to_hexstr(value_str, value, ECDH_CURVE25519_KEY_LENGTH);
+	  printf("FAIL %s (%s):\n  got      %s\n  expected %s\n", what,
+		 implementation, value_str, expected_hexstr);
+	  failures++;
+     }
+}
+
+// Test vectors of RFC 7748, sections 5.2 and 6.1.
+static const char *kat_scalar[2] = {
+     "a546e36bf0527c9d3b16154b82465edd62144c0ac1fc5a18506a2244ba449ac4",
+     "4b66e9d4d1b4673c5ad22691957d6af5c11b6421e0ea01d42ca4169e7918ba0d"
+};
+static const char *kat_u[2] = {
+     "e6db6867583030db3594c1a424b15f7c726624ec26b3353b10a903a6d0ab1c4c",
+     "e5210f12786811d3f4b7959d0538ae2c31dbe7106fc03c3efc4cd549c715a493"
+};
+static const char *kat_result[2] = {
+     "c3da55379de9c6908e94ea4df28d084f32eccf03491c71f754b4075577a28552",
+     "95cbde9476e8907d7aade45cb4b873f88b595a68799fa152e6f8f7647aac7957"
+};
+static const char *kat_iterated_1 =
+     "422c8e7a6227d7bca1350b3e2bb7279f7897b87bb6854b783c60e80311ae3079";
+static const char *kat_iterated_1000 =
+     "684cf59ba83309552800ef566f2f4d3c1c3887c49360e3875f2eb94d99532c51";
+static const char *kat_alice_secret_key =
+     "77076d0a7318a57d3c16c17251b26645df4c2f87ebc0992ab177fba51db92c2a";
+static const char *kat_alice_public_key =
+     "8520f0098930a754748b7ddcb43ef75a0dbf3a0d26381af4eba4a98eaa9b4e6a";
+static const char *kat_bob_secret_key =
+     "5dab087e624a8a4b79e17f8b83800ee66f3bb1292618b6fd1c2f8b27ff88e0eb";
+static const char *kat_bob_public_key =
+     "de9edb7d7b7dc1b4d35b61c2ece435373f8343c85b78674dadfc7e146f882b4f";
+static const char *kat_shared_secret =
+     "4a5d9d5ba4ce2de1728e3bf480350f25e07e21c947d19e3376f09b3c1e161742";
+
+typedef int (*scalarmult_fn)(unsigned char *r, const unsigned char *s,
+			     const unsigned char *p);
+
+// Known-answer tests of one implementation of crypto_scalarmult_curve25519.
+void test_scalarmult(const char *implementation, scalarmult_fn scalarmult)
+{
+     uint8_t s[ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t u[ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t r[ECDH_CURVE25519_KEY_LENGTH];
+
+     for (int i = 0; i < 2; i++) {
+	  hexstr_to_binary(s, kat_scalar[i], sizeof(s));
+	  hexstr_to_binary(u, kat_u[i], sizeof(u));
+	  scalarmult(r, s, u);
+	  check("RFC 7748 scalarmult", implementation, r, kat_result[i]);
+     }
+
+     // k = u = 9; then repeatedly k, u = X25519(k, u), k.
+     memset(s, 0, sizeof(s));
+     s[0] = 9;
+     memcpy(u, s, sizeof(u));
+     for (int i = 1; i <= 1000; i++) {
+	  scalarmult(r, s, u);
+	  memcpy(u, s, sizeof(u));
+	  memcpy(s, r, sizeof(s));
+	  if (i == 1)
+	       check("RFC 7748 iterated 1", implementation, s, kat_iterated_1);
+     }
+     check("RFC 7748 iterated 1000", implementation, s, kat_iterated_1000);
+
+     hexstr_to_binary(s, kat_alice_secret_key, sizeof(s));
+     hexstr_to_binary(u, kat_bob_public_key, sizeof(u));
+     scalarmult(r, s, u);
+     check("RFC 7748 shared secret", implementation, r, kat_shared_secret);
+     printf("%s: tested\n", implementation);
+}
+
+// Known-answer tests of the ECDH functions.
+void test_ecdh(void)
+{
+     uint8_t random[ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t secret_key[ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t public_key[ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t shared_secret[ECDH_CURVE25519_KEY_LENGTH];
+
+     // The secret key is the clamped random number.
+     memset(random, 0xff, sizeof(random));
+     ecdh_curve25519_secret_key(secret_key, random);
+     check("secret key", "ecdh", secret_key,
+	   "f8ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff7f");
+
+     hexstr_to_binary(secret_key, kat_alice_secret_key, sizeof(secret_key));
+     ecdh_curve25519_public_key(public_key, secret_key);
+     check("public key", "ecdh", public_key, kat_alice_public_key);
+     hexstr_to_binary(secret_key, kat_bob_secret_key, sizeof(secret_key));
+     ecdh_curve25519_public_key(public_key, secret_key);
+     check("public key", "ecdh", public_key, kat_bob_public_key);
+
+     hexstr_to_binary(public_key, kat_alice_public_key, sizeof(public_key));
+     ecdh_curve25519_shared_secret(shared_secret, secret_key, public_key);
+     check("shared secret", "ecdh", shared_secret, kat_shared_secret);
+}
+
+// u-coordinates of points of small order and non-canonical encodings of
+// them. In the ladder, these give Z = 0, which inverts to 0.
+static const char *low_order_u[5] = {
+     "0000000000000000000000000000000000000000000000000000000000000000",
+     "0100000000000000000000000000000000000000000000000000000000000000",
+     "e0eb7a7c3b41b8ae1656e3faf19fc46ada098deb9c32b1fd866205165f49b800",
+     "ecffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff7f",
+     "edffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff7f"
+};
+
+// Field elements at the edges of the encoding: 0, 1, p-1 = 2^255-20, p,
+// p+1, 2^255-1 and 2^256-1. The last four are not reduced.
+static const char *invert_edge[7] = {
+     "0000000000000000000000000000000000000000000000000000000000000000",
+     "0100000000000000000000000000000000000000000000000000000000000000",
+     "ecffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff7f",
+     "edffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff7f",
+     "eeffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff7f",
+     "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff7f",
+     "ffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff"
+};
+
+// Compare the safegcd inversion with the addition chain, and check that
+// x * x^-1 = 1 for x != 0.
+void test_invert(void)
+{
+     uint8_t buf[ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t chain[ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t safegcd[ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t one[ECDH_CURVE25519_KEY_LENGTH];
+     fe25519 x, r, t;
+
+     for (int i = 0; i < 1000; i++) {
+	  if (i < 7)
+	       hexstr_to_binary(buf, invert_edge[i], sizeof(buf));
+	  else
+	       create_random_number(buf, sizeof(buf));
+	  fe25519_unpack(&x, buf);
+	  fe25519_invert_chain(&r, &x);
+	  fe25519_pack(chain, &r);
+	  fe25519_invert_safegcd(&r, &x);
+	  fe25519_pack(safegcd, &r);
+	  if (memcmp(chain, safegcd, sizeof(chain)) != 0) {
+	       printf("FAIL invert: input %d\n", i);
+	       failures++;
+	  }
+	  if (!fe25519_iszero(&x)) {
+	       fe25519_mul(&t, &r, &x);
+	       fe25519_pack(one, &t);
+	       check("x * x^-1", "invert", one,
+		     "0100000000000000000000000000000000000000000000000000000000000000");
+	  }
+     }
+}
+
+// Compare fixed-base scalar multiplication on the Edwards curve with the
+// ladder on u = 9, including the scalars 0 and 2^256-1.
+void test_base(const char *implementation)
+{
+     uint8_t s[ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t nine[ECDH_CURVE25519_KEY_LENGTH] = {9};
+     uint8_t r[ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t expected[ECDH_CURVE25519_KEY_LENGTH];
+
+     for (int i = 0; i < 100; i++) {
+	  if (i < 2)
+	       memset(s, i == 0 ? 0x00 : 0xff, sizeof(s));
+	  else
+	       create_random_number(s, sizeof(s));
+	  crypto_scalarmult_curve25519_base(r, s);
+	  crypto_scalarmult_curve25519(expected, s, nine);
+	  if (memcmp(r, expected, sizeof(expected)) != 0) {
+	       printf("FAIL fixed base (%s): scalar %d\n", implementation, i);
+	       failures++;
+	  }
+     }
+}
+
+// Compare shared secrets computed with a peer context with the ladder.
+// Public keys made from secret keys use the precomputed table; random
+// u-coordinates are on the twist half of the time and, like low-order
+// points, fall back to the ladder.
+void test_ctx(const char *implementation)
+{
+     ecdh_curve25519_peer_ctx ctx;
+     const crypto_scalarmult_curve25519_precomp_ctx *precomp =
+	  (const crypto_scalarmult_curve25519_precomp_ctx *) ctx.opaque;
+     uint8_t secret_key[ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t public_key[ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t shared_secret[ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t expected[ECDH_CURVE25519_KEY_LENGTH];
+     int with_table = 0;
+
+     hexstr_to_binary(public_key, kat_bob_public_key, sizeof(public_key));
+     ecdh_curve25519_peer_precompute(&ctx, public_key);
+     hexstr_to_binary(secret_key, kat_alice_secret_key, sizeof(secret_key));
+     ecdh_curve25519_shared_secret_with_ctx(shared_secret, secret_key, &ctx);
+     check("shared secret with ctx", implementation, shared_secret,
+	   kat_shared_secret);
+
+     for (int i = 0; i < 30; i++) {
+	  if (i < 5) {
+	       hexstr_to_binary(public_key, low_order_u[i],
+				sizeof(public_key));
+	  } else if (i < 15) {
+	       create_random_number(public_key, sizeof(public_key));
+	  } else {
+	       create_random_number(secret_key, sizeof(secret_key));
+	       ecdh_curve25519_public_key(public_key, secret_key);
+	  }
+	  ecdh_curve25519_peer_precompute(&ctx, public_key);
+	  with_table += precomp->use_table;
+	  for (int j = 0; j < 3; j++) {
+	       create_random_number(secret_key, sizeof(secret_key));
+	       ecdh_curve25519_shared_secret_with_ctx(shared_secret,
+						      secret_key, &ctx);
+	       ecdh_curve25519_shared_secret(expected, secret_key,
+					     public_key);
+	       if (memcmp(shared_secret, expected, sizeof(expected)) != 0) {
+		    printf("FAIL shared secret with ctx (%s): key %d\n",
+			   implementation, i);
+		    failures++;
+	       }
+	  }
+     }
+     if (with_table < 15 || with_table == 30) {
+	  printf("FAIL ctx (%s): %d of 30 keys use the table\n",
+		 implementation, with_table);
+	  failures++;
+     }
+}
+
+// Compare the batch API with single shared secrets. 11 inputs fill two
+// rounds of the AVX2 kernel and leave three for the scalar code; the
+// low-order points end up in both parts.
+void test_batch(const char *implementation)
+{
+     uint8_t secret_key[11][ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t public_key[11][ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t shared_secret[11][ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t expected[ECDH_CURVE25519_KEY_LENGTH];
+
+     // RFC 7748 key exchange, both directions.
+     hexstr_to_binary(secret_key[0], kat_alice_secret_key,
+		      sizeof(secret_key[0]));
+     hexstr_to_binary(public_key[0], kat_bob_public_key,
+		      sizeof(public_key[0]));
+     hexstr_to_binary(secret_key[1], kat_bob_secret_key,
+		      sizeof(secret_key[1]));
+     hexstr_to_binary(public_key[1], kat_alice_public_key,
+		      sizeof(public_key[1]));
+     ecdh_curve25519_shared_secret_batch(shared_secret, secret_key,
+					 public_key, 2);
+     check("batch shared secret", implementation, shared_secret[0],
+	   kat_shared_secret);
+     check("batch shared secret", implementation, shared_secret[1],
+	   kat_shared_secret);
+
+     for (int i = 0; i < 11; i++) {
+	  create_random_number(secret_key[i], sizeof(secret_key[i]));
+	  create_random_number(public_key[i], sizeof(public_key[i]));
+     }
+     for (int i = 0; i < 5; i++)
+	  hexstr_to_binary(public_key[2*i + 1], low_order_u[i],
+			   sizeof(public_key[2*i + 1]));
+     ecdh_curve25519_shared_secret_batch(shared_secret, secret_key,
+					 public_key, 11);
+     for (int i = 0; i < 11; i++) {
+	  ecdh_curve25519_shared_secret(expected, secret_key[i],
+					public_key[i]);
+	  if (memcmp(shared_secret[i], expected, sizeof(expected)) != 0) {
+	       printf("FAIL batch shared secret (%s): input %d\n",
+		      implementation, i);
+	       failures++;
+	  }
+     }
+}
+
+#if defined(CURVE25519_AVX2)
+// Compare all four lanes of the AVX2 kernel with single scalar
+// multiplications. Every low-order point is tested in a different lane
+// next to random points.
+void test_avx2(void)
+{
+     uint8_t s[4][ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t u[4][ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t r[4][ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t expected[ECDH_CURVE25519_KEY_LENGTH];
+
+     for (int round = 0; round < 6; round++) {
+	  for (int k = 0; k < 4; k++) {
+	       create_random_number(s[k], sizeof(s[k]));
+	       create_random_number(u[k], sizeof(u[k]));
+	  }
+	  if (round < 5)
+	       hexstr_to_binary(u[round % 4], low_order_u[round],
+				sizeof(u[round % 4]));
+	  crypto_scalarmult_curve25519_avx2_x4(r, s, u);
+	  for (int k = 0; k < 4; k++) {
+	       crypto_scalarmult_curve25519(expected, s[k], u[k]);
+	       if (memcmp(r[k], expected, sizeof(expected)) != 0) {
+		    printf("FAIL avx2 x4: round %d, lane %d\n", round, k);
+		    failures++;
+	       }
+	  }
+     }
+     printf("avx2 x4: tested\n");
+}
+#endif
+
+// The worker pool must give the same results as single calls, for any
+// number of threads and batch size.
+void test_pool(void)
+{
+     static uint8_t secret_key[100][ECDH_CURVE25519_KEY_LENGTH];
+     static uint8_t public_key[100][ECDH_CURVE25519_KEY_LENGTH];
+     static uint8_t shared_secret[100][ECDH_CURVE25519_KEY_LENGTH];
+     uint8_t expected[ECDH_CURVE25519_KEY_LENGTH];
+     static const unsigned int threads[] = {1, 2, 3, 8};
+     static const size_t n[] = {0, 1, 5, 33, 100};
+
+     for (int i = 0; i < 100; i++) {
+	  create_random_number(secret_key[i], ECDH_CURVE25519_KEY_LENGTH);
+	  create_random_number(public_key[i], ECDH_CURVE25519_KEY_LENGTH);
+     }
+     for (int t = 0; t < 4; t++) {
+	  ecdh_curve25519_pool *pool = ecdh_curve25519_pool_create(threads[t]);
+	  if (pool == NULL) {
+	       printf("FAIL: cannot create pool with %u threads\n", threads[t]);
+	       failures++;
+	       continue;
+	  }
+	  for (int j = 0; j < 5; j++) {
+	       memset(shared_secret, 0, sizeof(shared_secret));
+	       ecdh_curve25519_shared_secret_batch_parallel(
+		    pool, shared_secret, secret_key, public_key, n[j]);
+	       for (size_t i = 0; i < n[j]; i++) {
+		    ecdh_curve25519_shared_secret(expected, secret_key[i],
+						  public_key[i]);
+		    if (memcmp(expected, shared_secret[i], sizeof(expected))) {
+			 printf("FAIL: pool with %u threads, batch of %zu, "
+				"entry %zu\n", threads[t], n[j], i);
+			 failures++;
+			 break;
+		    }
+	       }
+	  }
+	  ecdh_curve25519_pool_destroy(pool);
+     }
+}
+
 int main(int argc, char *argv[])
 {
      // First, we do the initial DH key exchange steps for Alice:
@@ -73,4 +454,37 @@ int main(int argc, char *argv[])
 	    
      printf("Alice's shared secret:\t%s\nBob's shared secret:\t%s\n", 
 	    alice_shared_secret_str, bob_shared_secret_str);
+     if (memcmp(alice_shared_secret, bob_shared_secret,
+		sizeof(alice_shared_secret)) != 0) {
+	  printf("FAIL: Alice and Bob do not share the same secret\n");
+	  failures++;
+     }
+
+     // Every implementation this CPU supports, then the default one again.
+     const char *implementation;
+     for (int i = 0; (implementation =
+		      crypto_scalarmult_curve25519_implementation_name(i)) != NULL;
+	  i++) {
+	  crypto_scalarmult_curve25519_select(implementation);
+	  test_scalarmult(implementation, crypto_scalarmult_curve25519);
+	  test_base(implementation);
+	  test_ctx(implementation);
+	  test_batch(implementation);
+     }
+     crypto_scalarmult_curve25519_select(NULL);
+     printf("default implementation: %s\n", ecdh_curve25519_implementation());
+#if defined(CURVE25519_AVX2)
+     if (crypto_scalarmult_curve25519_avx2_supported())
+	  test_avx2();
+#endif
+     test_ecdh();
+     test_invert();
+     test_pool();
+
+     if (failures != 0) {
+	  printf("%d tests failed\n", failures);
+	  return 1;
+     }
+     printf("all tests passed\n");
+     return 0;
 }
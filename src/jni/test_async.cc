@@ -0,0 +1,148 @@
+// Test of the coroutine interface of ecdh_curve25519_async.h: many
+// handshakes are in flight at the same time and are resumed by an epoll
+// loop through a completion queue, as in an event-loop server. The results
+// are compared to the synchronous functions.
+
+#include "ecdh_curve25519_async.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <poll.h>
+
+using namespace ecdh_curve25519;
+
+// Fire-and-forget coroutine, as a server would start one per connection.
+struct detached {
+     struct promise_type {
+	  detached get_return_object() { return {}; }
+	  std::suspend_never initial_suspend() noexcept { return {}; }
+	  std::suspend_never final_suspend() noexcept { return {}; }
+	  void return_void() {}
+	  void unhandled_exception() { std::terminate(); }
+     };
+};
+
+static int failures = 0;
+
+static void random_key(key &k)
+{
+     for (uint8_t &b : k)
+	  b = (uint8_t) rand();
+}
+
+struct handshake_state {
+     key alice_secret, bob_secret;
+     key alice_public, bob_public;
+     key alice_shared, bob_shared;
+     bool done = false;
+};
+
+// Both sides of a handshake; resumed on the thread calling queue.run().
+static detached handshake(executor &exec, completion_queue &queue,
+			  handshake_state &s, std::atomic<int> &outstanding)
+{
+     s.alice_public = co_await public_key(exec, s.alice_secret, &queue);
+     s.bob_public = co_await public_key(exec, s.bob_secret, &queue);
+     s.alice_shared = co_await shared_secret(exec, s.alice_secret,
+					     s.bob_public, &queue);
+     s.bob_shared = co_await shared_secret(exec, s.bob_secret,
+					   s.alice_public, &queue);
+     s.done = true;
+     outstanding--;
+}
+
+static void test_handshakes()
+{
+     const int n = 64;
+     // The executor is declared last, so that its threads are joined before
+     // the state they touch goes out of scope.
+     completion_queue queue;
+     handshake_state states[n];
+     std::atomic<int> outstanding(n);
+     executor exec(4);
+
+     for (int i = 0; i < n; i++) {
+	  random_key(states[i].alice_secret);
+	  random_key(states[i].bob_secret);
+	  handshake(exec, queue, states[i], outstanding);
+     }
+
+     // The event loop
+     struct pollfd pfd = { queue.fd(), POLLIN, 0 };
+     while (outstanding > 0) {
+	  if (poll(&pfd, 1, 10000) <= 0) {
+	       printf("FAIL async handshakes: no completion\n");
+	       failures++;
+	       return;
+	  }
+	  queue.run();
+     }
+
+     for (int i = 0; i < n; i++) {
+	  const handshake_state &s = states[i];
+	  key expected;
+	  ecdh_curve25519_public_key(expected.data(), s.alice_secret.data());
+	  if (!s.done || s.alice_public != expected ||
+	      s.alice_shared != s.bob_shared) {
+	       printf("FAIL async handshake %d\n", i);
+	       failures++;
+	       continue;
+	  }
+	  ecdh_curve25519_shared_secret(expected.data(), s.alice_secret.data(),
+					s.bob_public.data());
+	  if (s.alice_shared != expected) {
+	       printf("FAIL async shared secret %d\n", i);
+	       failures++;
+	  }
+     }
+}
+
+// Without completion queue, the coroutine is resumed on an executor thread.
+static detached batch(executor &exec, key *out, const key *secret,
+		      const key *peer, size_t n, std::atomic<bool> &done)
+{
+     co_await shared_secrets(exec, out, secret, peer, n);
+     done = true;
+     done.notify_one();
+}
+
+static void test_batch()
+{
+     const size_t n = 37;
+     key secret[n], peer[n], out[n];
+     std::atomic<bool> done(false);
+     executor exec(2);
+
+     for (size_t i = 0; i < n; i++) {
+	  random_key(secret[i]);
+	  random_key(peer[i]);
+     }
+     batch(exec, out, secret, peer, n, done);
+     done.wait(false);
+
+     for (size_t i = 0; i < n; i++) {
+	  key expected;
+	  ecdh_curve25519_shared_secret(expected.data(), secret[i].data(),
+					peer[i].data());
+	  if (out[i] != expected) {
+	       printf("FAIL async batch %zu\n", i);
+	       failures++;
+	  }
+     }
+}
+
+int main(int argc, char *argv[])
+{
+     test_handshakes();
+     test_batch();
+
+     if (failures != 0) {
+	  printf("%d test(s) failed\n", failures);
+	  return 1;
+     }
+     printf("All tests passed\n");
+     return 0;
+}
@@ -0,0 +1,175 @@
+/**
+ * This is free and unencumbered software released into the public domain.
+ *
+ * Anyone is free to copy, modify, publish, use, compile, sell, or
+ * distribute this software, either in source code form or as a compiled
+ * binary, for any purpose, commercial or non-commercial, and by any
+ * means.
+ *
+ * In jurisdictions that recognize copyright laws, the author or authors
+ * of this software dedicate any and all copyright interest in the
+ * software to the public domain. We make this dedication for the benefit
+ * of the public at large and to the detriment of our heirs and
+ * successors. We intend this dedication to be an overt act of
+ * relinquishment in perpetuity of all present and future rights to this
+ * software under copyright law.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.
+ * IN NO EVENT SHALL THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR
+ * OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR
+ * OTHER DEALINGS IN THE SOFTWARE.
+ *
+ * For more information, please refer to <http://unlicense.org/>
+ */
+
+package de.frank_durr.ecdhcurve25519test;
+
+import android.support.test.runner.AndroidJUnit4;
+
+import org.junit.BeforeClass;
+import org.junit.Test;
+import org.junit.runner.RunWith;
+
+import java.security.InvalidParameterException;
+import java.security.SecureRandom;
+import java.util.Arrays;
+import java.util.concurrent.CompletableFuture;
+import java.util.concurrent.ExecutionException;
+import java.util.concurrent.ExecutorService;
+import java.util.concurrent.Executors;
+import java.util.concurrent.TimeUnit;
+
+import de.frank_durr.ecdh_curve25519.ECDHCurve25519;
+import de.frank_durr.ecdh_curve25519.ECDHCurve25519Async;
+
+import static org.junit.Assert.*;
+
+/**
+ * Checks the results of ECDHCurve25519Async against the synchronous functions of
+ * ECDHCurve25519 on a device.
+ */
+@RunWith(AndroidJUnit4.class)
+public class ECDHCurve25519AsyncTest {
+    private static final long TIMEOUT_SECONDS = 60;
+
+    private final SecureRandom random = new SecureRandom();
+
+    @BeforeClass
+    public static void load_library() {
+        System.loadLibrary("ecdhcurve25519");
+    }
+
+    private static byte[] get(CompletableFuture<byte[]> future) throws Exception {
+        return future.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+    }
+
+    private static Throwable failure(CompletableFuture<byte[]> future) throws Exception {
+        try {
+            future.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+        } catch (ExecutionException e) {
+            return e.getCause();
+        }
+        fail("future completed normally");
+        return null;
+    }
+
+    @Test
+    public void public_key() throws Exception {
+        byte[] secret_key = ECDHCurve25519.generate_secret_key(random);
+        assertArrayEquals(ECDHCurve25519.generate_public_key(secret_key),
+                get(ECDHCurve25519Async.generate_public_key_async(secret_key)));
+    }
+
+    @Test
+    public void shared_secret() throws Exception {
+        byte[] alice_secret_key = ECDHCurve25519.generate_secret_key(random);
+        byte[] bob_secret_key = ECDHCurve25519.generate_secret_key(random);
+        byte[] alice_public_key = ECDHCurve25519.generate_public_key(alice_secret_key);
+        byte[] bob_public_key = ECDHCurve25519.generate_public_key(bob_secret_key);
+
+        byte[] alice_shared_secret = get(ECDHCurve25519Async.generate_shared_secret_async(
+                alice_secret_key, bob_public_key));
+        byte[] bob_shared_secret = get(ECDHCurve25519Async.generate_shared_secret_async(
+                bob_secret_key, alice_public_key));
+        assertArrayEquals(alice_shared_secret, bob_shared_secret);
+        assertArrayEquals(ECDHCurve25519.generate_shared_secret(alice_secret_key,
+                bob_public_key), alice_shared_secret);
+    }
+
+    @Test
+    public void inputs_are_copied() throws Exception {
+        byte[] my_secret_key = ECDHCurve25519.generate_secret_key(random);
+        byte[] other_public_key = ECDHCurve25519.generate_public_key(
+                ECDHCurve25519.generate_secret_key(random));
+        byte[] expected = ECDHCurve25519.generate_shared_secret(my_secret_key,
+                other_public_key);
+
+        CompletableFuture<byte[]> future = ECDHCurve25519Async.generate_shared_secret_async(
+                my_secret_key, other_public_key);
+        Arrays.fill(my_secret_key, (byte) 0);
+        Arrays.fill(other_public_key, (byte) 0);
+        assertArrayEquals(expected, get(future));
+    }
+
+    @Test
+    public void shared_secrets() throws Exception {
+        byte[] my_secret_key = ECDHCurve25519.generate_secret_key(random);
+        for (int count : new int[] {0, 1, 5, 33, 100}) {
+            byte[] other_public_keys = new byte[count*ECDHCurve25519.KEY_LENGTH];
+            for (int i = 0; i < count; i++) {
+                ECDHCurve25519.generate_public_key(ECDHCurve25519.generate_secret_key(random),
+                        0, other_public_keys, i*ECDHCurve25519.KEY_LENGTH);
+            }
+            byte[] expected = new byte[count*ECDHCurve25519.KEY_LENGTH];
+            ECDHCurve25519.generate_shared_secrets(my_secret_key, other_public_keys,
+                    expected, count);
+
+            assertArrayEquals(expected, get(ECDHCurve25519Async.generate_shared_secrets_async(
+                    my_secret_key, other_public_keys, count)));
+        }
+    }
+
+    @Test
+    public void invalid_count() throws Exception {
+        byte[] my_secret_key = ECDHCurve25519.generate_secret_key(random);
+        byte[] other_public_keys = new byte[2*ECDHCurve25519.KEY_LENGTH];
+        for (int count : new int[] {-1, 3, Integer.MAX_VALUE/ECDHCurve25519.KEY_LENGTH + 1,
+                Integer.MAX_VALUE}) {
+            assertTrue(failure(ECDHCurve25519Async.generate_shared_secrets_async(
+                    my_secret_key, other_public_keys, count))
+                    instanceof InvalidParameterException);
+        }
+        assertTrue(failure(ECDHCurve25519Async.generate_shared_secret_async(
+                my_secret_key, new byte[ECDHCurve25519.KEY_LENGTH - 1]))
+                instanceof InvalidParameterException);
+    }
+
+    @Test
+    public void callback_executor() throws Exception {
+        final Thread[] callback_thread = new Thread[1];
+        ExecutorService callback_executor = Executors.newSingleThreadExecutor(runnable -> {
+            callback_thread[0] = new Thread(runnable, "callback");
+            return callback_thread[0];
+        });
+        try {
+            byte[] secret_key = ECDHCurve25519.generate_secret_key(random);
+            final Thread[] completing_thread = new Thread[1];
+            CompletableFuture<byte[]> future = ECDHCurve25519Async.generate_public_key_async(
+                    secret_key, callback_executor);
+            // Completed on the callback thread, so a dependent action registered before
+            // completion runs there.
+            CompletableFuture<Void> dependent = future.thenRun(
+                    () -> completing_thread[0] = Thread.currentThread());
+            assertArrayEquals(ECDHCurve25519.generate_public_key(secret_key), get(future));
+            dependent.get(TIMEOUT_SECONDS, TimeUnit.SECONDS);
+            if (completing_thread[0] != Thread.currentThread()) {
+                assertSame(callback_thread[0], completing_thread[0]);
+            }
+        } finally {
+            callback_executor.shutdown();
+        }
+    }
+}